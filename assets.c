@@ -0,0 +1,137 @@
+// assets.c
+
+#include "assets.h"
+#include "blit.h"
+
+#define ASSET_FRAME (RES_X * RES_Y)
+
+// Below this many bytes a plain loop beats the set-up of a blit
+#define ASSET_SHORT 8
+
+static inline void copy_bytes(volatile unsigned char *dst, const volatile unsigned char *src,
+                              unsigned int n) {
+    if (n < ASSET_SHORT) {
+        for (unsigned int k = 0; k < n; ++k)
+            dst[k] = src[k];
+    } else {
+        blit_copy(dst, src, n);
+    }
+}
+
+static void rle_decode(const unsigned char *p, volatile unsigned char *dst) {
+    unsigned int out = 0;
+    while (out < ASSET_FRAME) {
+        unsigned int c = *p++;
+        if (c < 0x80) {
+            unsigned int n = c + 1;
+            copy_bytes(dst + out, p, n);
+            p += n;
+            out += n;
+        } else {
+            unsigned int n = (c & 0x7F) + 2;
+            unsigned char v = *p++;
+            if (n < ASSET_SHORT) {
+                for (unsigned int k = 0; k < n; ++k)
+                    dst[out + k] = v;
+            } else {
+                blit_fill(dst + out, v, n);
+            }
+            out += n;
+        }
+    }
+}
+
+static inline unsigned int lz_length(const unsigned char **p, unsigned int n) {
+    if (n == 15) {
+        unsigned int b;
+        do {
+            b = *(*p)++;
+            n += b;
+        } while (b == 255);
+    }
+    return n;
+}
+
+/* Matches are copied from the output itself, so no window buffer is needed: decoding
+ * into VRAM reads the match back from VRAM. A match that overlaps its own output
+ * (offset < length) repeats the last offset bytes and has to go a byte at a time. */
+static void lz_decode(const unsigned char *p, volatile unsigned char *dst) {
+    unsigned int out = 0;
+    for (;;) {
+        unsigned int token = *p++;
+        unsigned int n = lz_length(&p, token >> 4);
+        copy_bytes(dst + out, p, n);
+        p += n;
+        out += n;
+        if (out >= ASSET_FRAME) return;
+
+        unsigned int offset = p[0] | (p[1] << 8);
+        p += 2;
+        n = lz_length(&p, token & 15) + ASSET_LZ_MIN_MATCH;
+        volatile unsigned char *d = dst + out;
+        if (offset >= n) {
+            copy_bytes(d, d - offset, n);
+        } else {
+            for (unsigned int k = 0; k < n; ++k)
+                d[k] = d[(int)k - (int)offset];
+        }
+        out += n;
+    }
+}
+
+void asset_decode(const asset_t *a, volatile unsigned char *dst) {
+    if (a->codec == ASSET_RLE)
+        rle_decode(a->data, dst);
+    else
+        lz_decode(a->data, dst);
+}
+
+void asset_reader_init(asset_reader_t *r, const asset_t *a) {
+    r->p = a->data;
+    r->left = 0;
+    r->run = 0;
+    r->value = 0;
+}
+
+void asset_read(asset_reader_t *r, unsigned char *dst, int n) {
+    while (n > 0) {
+        if (r->left == 0) {
+            unsigned int c = *r->p++;
+            r->run = c >= 0x80;
+            if (r->run) {
+                r->left = (c & 0x7F) + 2;
+                r->value = *r->p++;
+            } else {
+                r->left = c + 1;
+            }
+        }
+        int k = r->left < n ? r->left : n;
+        if (r->run) {
+            blit_fill(dst, r->value, k);
+        } else {
+            blit_copy(dst, r->p, k);
+            r->p += k;
+        }
+        dst += k;
+        n -= k;
+        r->left -= k;
+    }
+}
+
+static unsigned char diff_rows[2][RES_X];
+
+int asset_diff(vga_diff_t *d, const asset_t *a, const asset_t *b) {
+    if (a->codec != ASSET_RLE || b->codec != ASSET_RLE) {
+        d->n_spans = -1;
+        return -1;
+    }
+    asset_reader_t ra, rb;
+    asset_reader_init(&ra, a);
+    asset_reader_init(&rb, b);
+    for (int y = 0; y < RES_Y && d->n_spans >= 0; ++y) {
+        asset_read(&ra, diff_rows[0], RES_X);
+        asset_read(&rb, diff_rows[1], RES_X);
+        vga_diff_row(d, y, diff_rows[0], diff_rows[1]);
+    }
+    return d->n_spans;
+}
@@ -0,0 +1,45 @@
+// assets.h
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "vga.h"
+
+// Compressed full-screen (RES_X x RES_Y) images, generated by pack_assets.py.
+//
+// ASSET_RLE, for flat menu art: a control byte c < 0x80 is followed by c + 1 literal
+// bytes, c >= 0x80 by one byte repeated (c & 0x7F) + 2 times.
+//
+// ASSET_LZ, for photos: sequences of a token, literals and a match. The token's high
+// nibble is the literal count, its low nibble the match length - 3; a nibble of 15 is
+// extended by the bytes that follow it (each added, 255 means another one follows).
+// The literal count extension comes right after the token, the match length extension
+// after the match's 16-bit little-endian offset. The last sequence has literals only.
+typedef enum { ASSET_RLE, ASSET_LZ } asset_codec_t;
+
+typedef struct {
+    asset_codec_t codec;
+    unsigned int size;            // compressed bytes
+    const unsigned char *data;
+} asset_t;
+
+#define ASSET_LZ_MIN_MATCH 3
+
+// Decode a whole image straight into dst (VRAM or RAM); LZ matches are read back from dst
+void asset_decode(const asset_t *a, volatile unsigned char *dst);
+
+// Decode an RLE image a row at a time, when it is not wanted in one piece
+typedef struct {
+    const unsigned char *p;
+    int left;                     // bytes left in the current literal or run
+    int run;                      // the current control is a run of value
+    unsigned char value;
+} asset_reader_t;
+
+void asset_reader_init(asset_reader_t *r, const asset_t *a);
+void asset_read(asset_reader_t *r, unsigned char *dst, int n);
+
+// Difference spans between two RLE images (see vga_diff_t); -1 if they do not fit
+int asset_diff(vga_diff_t *d, const asset_t *a, const asset_t *b);
+
+#endif // ASSETS_H
@@ -3,12 +3,13 @@
 #ifndef BACKGROUND_H
 #define BACKGROUND_H
 #include "vga.h"
+#include "assets.h"
 
-// Images
-extern unsigned char test1[RES_Y][RES_X];
-extern unsigned char Bliss[RES_Y][RES_X];
-extern unsigned char KTH[RES_Y][RES_X];
-extern unsigned char Icecream[RES_Y][RES_X];
+// Images, compressed; decode with asset_decode()
+extern const asset_t asset_test1;
+extern const asset_t asset_bliss;
+extern const asset_t asset_kth;
+extern const asset_t asset_icecream;
 
 // Sprites
 extern const unsigned char arrowSprite[20][20];
@@ -16,16 +17,9 @@ extern const unsigned char handSprite[20][20];
 
 // Backgrounds
 
-// Stylized
-extern const unsigned char mainMenuStyle[RES_Y][RES_X];
-extern const unsigned char processMenuStyle[RES_Y][RES_X];
-extern const unsigned char uploadMenuStyle[RES_Y][RES_X];
+// Stylized, compressed
+extern const asset_t asset_main_menu;
+extern const asset_t asset_process_menu;
+extern const asset_t asset_upload_menu;
 
-// Original
-/*
-extern const unsigned char mainMenu[RES_Y][RES_X];
-extern const unsigned char ProcessMenu[RES_Y][RES_X];
-extern const unsigned char UploadMenu[RES_Y][RES_X];
-*/
-
-#endif
\ No newline at end of file
+#endif
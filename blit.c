@@ -0,0 +1,83 @@
+// blit.c
+
+#include "blit.h"
+
+void blit_copy(volatile void *dst, const volatile void *src, unsigned int n) {
+    volatile unsigned char *d = (volatile unsigned char *)dst;
+    const volatile unsigned char *s = (const volatile unsigned char *)src;
+
+    // Head: bytes until the destination is word aligned
+    while (n && ((unsigned int)d & 3)) {
+        *d++ = *s++;
+        n--;
+    }
+
+    volatile unsigned int *dw = (volatile unsigned int *)d;
+    unsigned int words = n >> 2;
+    unsigned int shift = ((unsigned int)s & 3) * 8;
+    if (shift == 0) {
+        const volatile unsigned int *sw = (const volatile unsigned int *)s;
+        for (; words >= 8; words -= 8, dw += 8, sw += 8) {
+            unsigned int w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+            unsigned int w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+            dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+            dw[4] = w4; dw[5] = w5; dw[6] = w6; dw[7] = w7;
+        }
+        while (words--)
+            *dw++ = *sw++;
+    } else {
+        // Little endian: each destination word is the top of one aligned source word
+        // and the bottom of the next. Only words holding source bytes are read.
+        const volatile unsigned int *sw = (const volatile unsigned int *)((unsigned int)s & ~3u);
+        unsigned int back = 32 - shift;
+        unsigned int lo = *sw++;
+        for (; words >= 4; words -= 4, dw += 4, sw += 4) {
+            unsigned int h0 = sw[0], h1 = sw[1], h2 = sw[2], h3 = sw[3];
+            dw[0] = (lo >> shift) | (h0 << back);
+            dw[1] = (h0 >> shift) | (h1 << back);
+            dw[2] = (h1 >> shift) | (h2 << back);
+            dw[3] = (h2 >> shift) | (h3 << back);
+            lo = h3;
+        }
+        while (words--) {
+            unsigned int hi = *sw++;
+            *dw++ = (lo >> shift) | (hi << back);
+            lo = hi;
+        }
+    }
+
+    // Tail
+    d += n & ~3u;
+    s += n & ~3u;
+    for (n &= 3; n; --n)
+        *d++ = *s++;
+}
+
+void blit_fill(volatile void *dst, unsigned char value, unsigned int n) {
+    volatile unsigned char *d = (volatile unsigned char *)dst;
+    while (n && ((unsigned int)d & 3)) {
+        *d++ = value;
+        n--;
+    }
+
+    volatile unsigned int *dw = (volatile unsigned int *)d;
+    unsigned int v = value * 0x01010101u;
+    unsigned int words = n >> 2;
+    for (; words >= 8; words -= 8, dw += 8) {
+        dw[0] = v; dw[1] = v; dw[2] = v; dw[3] = v;
+        dw[4] = v; dw[5] = v; dw[6] = v; dw[7] = v;
+    }
+    while (words--)
+        *dw++ = v;
+
+    d += n & ~3u;
+    for (n &= 3; n; --n)
+        *d++ = value;
+}
+
+void blit_rect(volatile unsigned char *dst, int dst_stride,
+               const volatile unsigned char *src, int src_stride, int w, int h) {
+    if (w <= 0) return;
+    for (int y = 0; y < h; ++y, dst += dst_stride, src += src_stride)
+        blit_copy(dst, src, w);
+}
@@ -0,0 +1,25 @@
+// blit.h
+
+#ifndef BLIT_H
+#define BLIT_H
+
+#include "vga.h"
+
+// Bulk copy and fill without libc (the build is -nostdlib -fno-builtin).
+// Whole words are moved 32 bytes per iteration once the destination is aligned,
+// so a full frame costs a quarter of the bus transactions of a byte loop.
+// A source that is not aligned like the destination is merged from aligned words.
+void blit_copy(volatile void *dst, const volatile void *src, unsigned int n);
+void blit_fill(volatile void *dst, unsigned char value, unsigned int n);
+
+// w x h rectangle between buffers with the given row strides (bytes)
+void blit_rect(volatile unsigned char *dst, int dst_stride,
+               const volatile unsigned char *src, int src_stride, int w, int h);
+
+// Whole 320x240 frames
+#define BLIT_FRAME (RES_X * RES_Y)
+static inline void blit_frame(volatile void *dst, const volatile void *src) {
+    blit_copy(dst, src, BLIT_FRAME);
+}
+
+#endif // BLIT_H
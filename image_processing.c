@@ -11,15 +11,44 @@ static inline unsigned char clamp255(int v) {
     return (unsigned char)v;
 }
 
-// Get pixel with border replication (clamping). Handles edge cases gracefully.
-// For pixels at image boundaries, uses the nearest valid pixel instead of crashing.
-// This creates a "reflected" border effect for convolution filters.
-static inline unsigned char pixel_at(const unsigned char img[RES_Y][RES_X], int y, int x) {
+#if IP_EDGE_POLICY == IP_EDGE_ZERO
+// All-black row standing in for rows outside the image
+static const unsigned char zero_row[RES_X];
+#endif
+
+// Row y through the compile-time edge policy (see IP_EDGE_POLICY in image_processing.h).
+// Only called for y = -1 and y = RES_Y; rows inside the image are used directly.
+static inline const unsigned char *row_at(const unsigned char img[RES_Y][RES_X], int y) {
+#if IP_EDGE_POLICY == IP_EDGE_ZERO
+    if (y < 0 || y >= RES_Y) return zero_row;
+#elif IP_EDGE_POLICY == IP_EDGE_MIRROR
+    if (y < 0) y = -y;
+    if (y >= RES_Y) y = 2 * (RES_Y - 1) - y;
+#elif IP_EDGE_POLICY == IP_EDGE_WRAP
+    if (y < 0) y += RES_Y;
+    if (y >= RES_Y) y -= RES_Y;
+#else // IP_EDGE_CLAMP
     if (y < 0) y = 0;
     if (y >= RES_Y) y = RES_Y - 1;
+#endif
+    return img[y];
+}
+
+// Pixel x of a row through the edge policy. Only the border columns go through here.
+static inline unsigned char col_at(const unsigned char *row, int x) {
+#if IP_EDGE_POLICY == IP_EDGE_ZERO
+    if (x < 0 || x >= RES_X) return 0;
+#elif IP_EDGE_POLICY == IP_EDGE_MIRROR
+    if (x < 0) x = -x;
+    if (x >= RES_X) x = 2 * (RES_X - 1) - x;
+#elif IP_EDGE_POLICY == IP_EDGE_WRAP
+    if (x < 0) x += RES_X;
+    if (x >= RES_X) x -= RES_X;
+#else // IP_EDGE_CLAMP
     if (x < 0) x = 0;
     if (x >= RES_X) x = RES_X - 1;
-    return img[y][x];
+#endif
+    return row[x];
 }
 
 // Extract color components from RRRGGBB pixel (3-2-2 format)
@@ -46,37 +75,82 @@ static inline void dst_write(volatile unsigned char *dst, int y, int x, unsigned
     dst[y * RES_X + x] = v;
 }
 
+/* 3x3 kernel cores and rows.
+ * Each core computes one output pixel from three row pointers (top, middle, bottom),
+ * each pointing at column x-1 of the window. A row function (name##_row) produces a
+ * whole output row: its interior slides along the rows with no edge checks, and only
+ * the two border columns gather their window through col_at() and call the core.
+ */
+typedef unsigned char (*kernel3x3_fn)(const unsigned char *t, const unsigned char *m, const unsigned char *b);
+typedef void (*row3x3_fn)(const unsigned char *t, const unsigned char *m, const unsigned char *b, volatile unsigned char *out);
+
+// Gather the 3x3 window around border column x through col_at()
+static void fill_window_3x3(const unsigned char *t, const unsigned char *m, const unsigned char *b, int x, unsigned char win[3][3]) {
+    const unsigned char *rows[3] = { t, m, b };
+    for (int ky = 0; ky < 3; ++ky)
+        for (int kx = 0; kx < 3; ++kx)
+            win[ky][kx] = col_at(rows[ky], x + kx - 1);
+}
+
+static unsigned char edge_px_3x3(const unsigned char *t, const unsigned char *m, const unsigned char *b, int x, kernel3x3_fn core) {
+    unsigned char win[3][3];
+    fill_window_3x3(t, m, b, x, win);
+    return core(win[0], win[1], win[2]);
+}
+
+// Whole frame: only the rows above the first and below the last go through row_at()
+static void run_3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, row3x3_fn row) {
+    row(row_at(src, -1), src[0], src[1], dst);
+    for (int y = 1; y < RES_Y - 1; ++y)
+        row(src[y - 1], src[y], src[y + 1], dst + y * RES_X);
+    row(src[RES_Y - 2], src[RES_Y - 1], row_at(src, RES_Y), dst + (RES_Y - 1) * RES_X);
+}
+
+/* Point filters via 256-entry lookup tables
+ * A 3-2-2 pixel is a single byte, so any per-pixel function of that byte is fully
+ * described by a 256-byte table. Each point filter builds its table once (on first use)
+ * and ip_apply_lut() then costs one load + one table load + one store per pixel.
+ * Two tables compose into one with ip_compose_lut(), so a chain of point filters
+ * still runs as a single pass.
+ */
+void ip_apply_lut(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, const unsigned char lut[256]) {
+    if (!dst) return;
+    const unsigned char *s = &src[0][0];
+    for (int i = 0; i < RES_X * RES_Y; ++i)
+        dst[i] = lut[s[i]];
+}
+
+// out = second(first(p)) for every byte p
+void ip_compose_lut(const unsigned char first[256], const unsigned char second[256], unsigned char out[256]) {
+    for (int i = 0; i < 256; ++i)
+        out[i] = second[first[i]];
+}
+
 /* 1) Grayscale Conversion - Simpler version
  * Uses weighted average of R,G,B channels 
  */
-void ip_grayscale(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
-    if (!dst) return;
-    for (int y = 0; y < RES_Y; ++y) {
-        for (int x = 0; x < RES_X; ++x) {
+static unsigned char grayscale_px(unsigned char p) {
+    unsigned char r = get_red(p);
+    unsigned char g = get_green(p);
+    unsigned char b = get_blue(p);
 
-            unsigned char r = get_red(pixel_at(src, y, x));
-            unsigned char g = get_green(pixel_at(src, y, x));
-            unsigned char b = get_blue(pixel_at(src, y, x));
-            
-            // Scale green and blue to match red's range (0-7)
-            // Green: 0-3 → 0-6 (multiply by 2)
-            // Blue: 0-3 → 0-6 (multiply by 2)
-            int g_scaled = g * 2;
-            int b_scaled = b * 2;
-            
-            // Weighted average (you can adjust weights)
-            int gray = (r + g_scaled + b_scaled) / 3;
-            
-            // Ensure in 0-7 range
-            if (gray > 7) gray = 7;
-            
-            // Convert back to output channels
-            unsigned char out_g = gray >> 1;  // 0-7 → 0-3
-            unsigned char out_b = gray >> 1;  // 0-7 → 0-3
-            
-            dst_write(dst, y, x, make_rgb(gray, out_g, out_b));
-        }
-    }
+    // Scale green and blue to match red's range (0-7)
+    // Green: 0-3 → 0-6 (multiply by 2)
+    // Blue: 0-3 → 0-6 (multiply by 2)
+    int g_scaled = g * 2;
+    int b_scaled = b * 2;
+
+    // Weighted average (you can adjust weights)
+    int gray = (r + g_scaled + b_scaled) / 3;
+
+    // Ensure in 0-7 range
+    if (gray > 7) gray = 7;
+
+    // Convert back to output channels
+    unsigned char out_g = gray >> 1;  // 0-7 → 0-3
+    unsigned char out_b = gray >> 1;  // 0-7 → 0-3
+
+    return make_rgb(gray, out_g, out_b);
 }
 
 /* 2) Black & White using threshold
@@ -84,14 +158,8 @@ void ip_grayscale(const unsigned char src[RES_Y][RES_X], volatile unsigned char
  * Pixel >= 128 becomes white (255), otherwise black (0)
  * Uses the overall pixel brightness, not individual color channels
  */
-void ip_blackwhite(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
-    if (!dst) return;
-    for (int y = 0; y < RES_Y; ++y) {
-        for (int x = 0; x < RES_X; ++x) {
-            unsigned char s = src[y][x];
-            dst_write(dst, y, x, (s >= 128) ? 255 : 0);
-        }
-    }
+static unsigned char blackwhite_px(unsigned char p) {
+    return (p >= 128) ? 255 : 0;
 }
 
 /* 3) Invert: Simple color inversion
@@ -99,29 +167,195 @@ void ip_blackwhite(const unsigned char src[RES_Y][RES_X], volatile unsigned char
  * Works on RRRGGBB format because it preserves channel relationships
  * Bright becomes dark, colors become their complements
  */
-void ip_invert(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
-    if (!dst) return;
-    for (int y = 0; y < RES_Y; ++y) {
-        for (int x = 0; x < RES_X; ++x) {
-            unsigned char s = src[y][x];
-            dst_write(dst, y, x, (unsigned char)(255 - s));
-        }
-    }
+static unsigned char invert_px(unsigned char p) {
+    return (unsigned char)(255 - p);
+}
+
+/* Sepia tone
+ * Expands each channel to 0-255, applies the usual sepia matrix (x1000 fixed point)
+ * and quantizes back to 3-2-2. The division only happens while building the table.
+ */
+static unsigned char sepia_px(unsigned char p) {
+    int r = get_red(p) * 255 / 7;
+    int g = get_green(p) * 255 / 3;
+    int b = get_blue(p) * 255 / 3;
+
+    int sr = (393 * r + 769 * g + 189 * b) / 1000;
+    int sg = (349 * r + 686 * g + 168 * b) / 1000;
+    int sb = (272 * r + 534 * g + 131 * b) / 1000;
+
+    return make_rgb(clamp255(sr) >> 5, clamp255(sg) >> 6, clamp255(sb) >> 6);
+}
+
+/* Posterize: keep only the top bit of each channel (2 levels per channel, 8 colors) */
+static unsigned char posterize_px(unsigned char p) {
+    unsigned char r = (get_red(p) >= 4) ? 7 : 0;
+    unsigned char g = (get_green(p) >= 2) ? 3 : 0;
+    unsigned char b = (get_blue(p) >= 2) ? 3 : 0;
+    return make_rgb(r, g, b);
+}
+
+/* Channel isolation: keep one channel, zero the other two */
+static unsigned char red_only_px(unsigned char p)   { return make_rgb(get_red(p), 0, 0); }
+static unsigned char green_only_px(unsigned char p) { return make_rgb(0, get_green(p), 0); }
+static unsigned char blue_only_px(unsigned char p)  { return make_rgb(0, 0, get_blue(p)); }
+
+/* Gamma 0.5 (brightens shadows)
+ * out = max * sqrt(in / max), rounded, precomputed per channel depth
+ */
+static const unsigned char gamma_3bit[8] = { 0, 3, 4, 5, 5, 6, 6, 7 };
+static const unsigned char gamma_2bit[4] = { 0, 2, 2, 3 };
+
+static unsigned char gamma_px(unsigned char p) {
+    return make_rgb(gamma_3bit[get_red(p)], gamma_2bit[get_green(p)], gamma_2bit[get_blue(p)]);
 }
 
+// Define the lazily built table and the full-frame filter for one point function
+#define IP_POINT_FILTER(name)                                                               \
+    const unsigned char *ip_lut_##name(void) {                                              \
+        static unsigned char lut[256];                                                      \
+        static int built = 0;                                                               \
+        if (!built) {                                                                       \
+            for (int i = 0; i < 256; ++i)                                                   \
+                lut[i] = name##_px((unsigned char)i);                                       \
+            built = 1;                                                                      \
+        }                                                                                   \
+        return lut;                                                                         \
+    }                                                                                       \
+    void ip_##name(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {    \
+        ip_apply_lut(src, dst, ip_lut_##name());                                            \
+    }
+
+IP_POINT_FILTER(grayscale)
+IP_POINT_FILTER(blackwhite)
+IP_POINT_FILTER(invert)
+IP_POINT_FILTER(sepia)
+IP_POINT_FILTER(posterize)
+IP_POINT_FILTER(red_only)
+IP_POINT_FILTER(green_only)
+IP_POINT_FILTER(blue_only)
+IP_POINT_FILTER(gamma)
+
 /* 4) Mirror (horizontal flip)
  * Reflects image across vertical center axis
  * Pixel at (x,y) moves to (width-1-x, y)
  * Pure spatial transformation - no pixel value changes
  */
+static void mirror_row(const unsigned char *in, volatile unsigned char *out) {
+    for (int x = 0; x < RES_X; ++x)
+        out[x] = in[RES_X - 1 - x];
+}
+
 void ip_mirror(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
     if (!dst) return;
+    for (int y = 0; y < RES_Y; ++y)
+        mirror_row(src[y], dst + y * RES_X);
+}
+
+/* SWAR (SIMD within a register) variants of Invert, Black & White and Mirror
+ * rv32im has no vector unit, but a 32-bit word holds four pixels. These load four
+ * pixels per lw, transform them with plain bitwise operations and write one aligned sw
+ * into the framebuffer. Output is bit-exact with the byte versions above.
+ * Both buffers must be word aligned (RES_X is a multiple of 4, so every row is too);
+ * otherwise they fall back to the byte versions.
+ */
+#define SWAR_LO 0x01010101u
+#define SWAR_HI 0x80808080u
+#define BW_THRESHOLD 128
+
+static inline int swar_aligned(const void *src, volatile void *dst) {
+    return (((unsigned int)src | (unsigned int)dst) & 3) == 0;
+}
+
+// Per byte: 0x80 where byte >= t, else 0. 't' is a compile-time constant here.
+static inline unsigned int swar_ge_mask(unsigned int w, unsigned int t) {
+    // Compare the low 7 bits with the top bit of each byte as a borrow guard
+    unsigned int lo_ge = (((w & ~SWAR_HI) | SWAR_HI) - (t & 0x7F) * SWAR_LO) & SWAR_HI;
+    unsigned int hi = w & SWAR_HI;
+    return (t & 0x80) ? (hi & lo_ge) : (hi | lo_ge);
+}
+
+// 0x80 -> 0xFF per byte
+static inline unsigned int swar_expand_mask(unsigned int m) {
+    return (m << 1) - (m >> 7);
+}
+
+// Reverse the four bytes of a word with shifts and masks
+static inline unsigned int swar_bswap(unsigned int w) {
+    return (w >> 24) | ((w >> 8) & 0x0000FF00u) | ((w << 8) & 0x00FF0000u) | (w << 24);
+}
+
+void ip_invert_swar(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (!dst) return;
+    if (!swar_aligned(src, dst)) { ip_invert(src, dst); return; }
+    const unsigned int *s = (const unsigned int *)&src[0][0];
+    volatile unsigned int *d = (volatile unsigned int *)dst;
+    for (int i = 0; i < RES_X * RES_Y / 4; ++i)
+        d[i] = ~s[i]; // 255 - p == ~p for every byte
+}
+
+void ip_blackwhite_swar(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (!dst) return;
+    if (!swar_aligned(src, dst)) { ip_blackwhite(src, dst); return; }
+    const unsigned int *s = (const unsigned int *)&src[0][0];
+    volatile unsigned int *d = (volatile unsigned int *)dst;
+    for (int i = 0; i < RES_X * RES_Y / 4; ++i)
+        d[i] = swar_expand_mask(swar_ge_mask(s[i], BW_THRESHOLD));
+}
+
+void ip_mirror_swar(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (!dst) return;
+    if (!swar_aligned(src, dst)) { ip_mirror(src, dst); return; }
     for (int y = 0; y < RES_Y; ++y) {
-        for (int x = 0; x < RES_X; ++x) {
-            unsigned char s = src[y][RES_X - 1 - x];
-            dst_write(dst, y, x, s);
-        }
+        const unsigned int *s = (const unsigned int *)src[y];
+        volatile unsigned int *d = (volatile unsigned int *)(dst + y * RES_X);
+        for (int i = 0; i < RES_X / 4; ++i)
+            d[i] = swar_bswap(s[RES_X / 4 - 1 - i]);
+    }
+}
+
+/* Channel-parallel lanes for the 3x3 filters
+ * lane_decode[] expands one RRRGGBB byte into a word with red, green and blue in separate
+ * 10-bit lanes (bits 0-9, 10-19, 20-29). A 3x3 window sum per channel stays far below
+ * 1024, so adding decoded words accumulates all three channels with one add per tap.
+ * Signed kernels add LANE_BIAS first so no lane ever borrows from its neighbour.
+ * The final divide/clamp/abs per channel is a lookup in a small table indexed by the
+ * lane value, with the result already shifted into its 3-2-2 position.
+ */
+#define LANE_G_SHIFT 10
+#define LANE_B_SHIFT 20
+#define LANE_MASK    0x3F   // every lane value used below is < 64 ...
+#define LANE_MASK_SH 0x7F   // ... except biased sharpen sums (< 128)
+#define LANE_BIAS    (32u | (32u << LANE_G_SHIFT) | (32u << LANE_B_SHIFT))
+#define LANE_ONES    (1u | (1u << LANE_G_SHIFT) | (1u << LANE_B_SHIFT))
+
+static unsigned int lane_decode[256];
+static unsigned char blur_div9[3][64];     // (sum / 9) in channel position
+static unsigned char sharpen_clamp[3][128]; // clamp(v - 32) in channel position
+static unsigned char sobel_abs[64];         // |v - 32|
+static unsigned char sobel_norm[3][64];     // min(mag / 8, lim) in channel position
+static int lanes_ready = 0;
+
+static void lanes_init(void) {
+    if (lanes_ready) return;
+    for (int p = 0; p < 256; ++p)
+        lane_decode[p] = get_red(p) | (get_green(p) << LANE_G_SHIFT) | (get_blue(p) << LANE_B_SHIFT);
+    for (int v = 0; v < 64; ++v) {
+        blur_div9[0][v] = make_rgb(v / 9, 0, 0);
+        blur_div9[1][v] = make_rgb(0, v / 9, 0);
+        blur_div9[2][v] = make_rgb(0, 0, v / 9);
+        sobel_abs[v] = (v < 32) ? 32 - v : v - 32;
+        sobel_norm[0][v] = make_rgb((v / 8 > 7) ? 7 : v / 8, 0, 0);
+        sobel_norm[1][v] = make_rgb(0, (v / 8 > 7) ? 7 : v / 8, 0);
+        sobel_norm[2][v] = make_rgb(0, 0, (v / 8 > 3) ? 3 : v / 8);
     }
+    for (int v = 0; v < 128; ++v) {
+        int c = v - 32;
+        sharpen_clamp[0][v] = make_rgb((c < 0) ? 0 : (c > 7) ? 7 : c, 0, 0);
+        sharpen_clamp[1][v] = make_rgb(0, (c < 0) ? 0 : (c > 7) ? 7 : c, 0);  // clamped to 7 like the packed filter
+        sharpen_clamp[2][v] = make_rgb(0, 0, (c < 0) ? 0 : (c > 3) ? 3 : c);
+    }
+    lanes_ready = 1;
 }
 
 /* 5) Blur 3x3 (box blur) - Low-pass filter
@@ -138,30 +372,49 @@ void ip_mirror(const unsigned char src[RES_Y][RES_X], volatile unsigned char *ds
  * Effect: Reduces noise and detail, creates smooth appearance
  * Processes R,G,B channels separately to maintain color integrity
  */
-void ip_blur3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
-    if (!dst) return;
-    for (int y = 0; y < RES_Y; ++y) {
-        for (int x = 0; x < RES_X; ++x) {
-            int sum_r = 0, sum_g = 0, sum_b = 0;
-            
-            // Sum 3x3 neighborhood for each color channel
-            for (int ky = -1; ky <= 1; ++ky) {
-                for (int kx = -1; kx <= 1; ++kx) {
-                    unsigned char pixel = pixel_at(src, y + ky, x + kx);
-                    sum_r += get_red(pixel);
-                    sum_g += get_green(pixel);
-                    sum_b += get_blue(pixel);
-                }
-            }
-            
-            // Average and output (integer division for speed)
-            unsigned char out_r = sum_r / 9;
-            unsigned char out_g = sum_g / 9;
-            unsigned char out_b = sum_b / 9;
-            
-            dst_write(dst, y, x, make_rgb(out_r, out_g, out_b));
+static inline unsigned char blur_core(const unsigned char *t, const unsigned char *m, const unsigned char *b) {
+    const unsigned char *rows[3] = { t, m, b };
+    int sum_r = 0, sum_g = 0, sum_b = 0;
+
+    // Sum 3x3 neighborhood for each color channel
+    for (int ky = 0; ky < 3; ++ky) {
+        for (int kx = 0; kx < 3; ++kx) {
+            unsigned char pixel = rows[ky][kx];
+            sum_r += get_red(pixel);
+            sum_g += get_green(pixel);
+            sum_b += get_blue(pixel);
         }
     }
+
+    // Average and output (integer division for speed)
+    return make_rgb(sum_r / 9, sum_g / 9, sum_b / 9);
+}
+
+/* Row with lanes: each column sum (3 decoded pixels) is computed once and shared by
+ * the three windows that contain it, then /9 per channel is a table lookup.
+ */
+static void blur_row(const unsigned char *t, const unsigned char *m, const unsigned char *b, volatile unsigned char *out) {
+    lanes_init();
+    out[0] = edge_px_3x3(t, m, b, 0, blur_core);
+
+    unsigned int ca = lane_decode[t[0]] + lane_decode[m[0]] + lane_decode[b[0]];
+    unsigned int cc = lane_decode[t[1]] + lane_decode[m[1]] + lane_decode[b[1]];
+    for (int x = 1; x < RES_X - 1; ++x) {
+        unsigned int cn = lane_decode[t[x + 1]] + lane_decode[m[x + 1]] + lane_decode[b[x + 1]];
+        unsigned int sum = ca + cc + cn;
+        out[x] = blur_div9[0][sum & LANE_MASK]
+               | blur_div9[1][(sum >> LANE_G_SHIFT) & LANE_MASK]
+               | blur_div9[2][(sum >> LANE_B_SHIFT) & LANE_MASK];
+        ca = cc;
+        cc = cn;
+    }
+
+    out[RES_X - 1] = edge_px_3x3(t, m, b, RES_X - 1, blur_core);
+}
+
+void ip_blur3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (!dst) return;
+    run_3x3(src, dst, blur_row);
 }
 
 /* 6) Sharpen 3x3 - High-pass filter for edge enhancement
@@ -174,43 +427,67 @@ void ip_blur3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *d
  * Amplifies high-frequency details (edges) while reducing flat areas
  * The negative weights create a differential effect that enhances contrasts
  */
+// Clamp each channel to its valid range (R:0-7, G:0-7, B:0-3) and pack
+static inline unsigned char sharpen_pack(int r, int g, int b) {
+    unsigned char out_r = (r < 0) ? 0 : (r > 7) ? 7 : r;
+    unsigned char out_g = (g < 0) ? 0 : (g > 7) ? 7 : g;
+    unsigned char out_b = (b < 0) ? 0 : (b > 3) ? 3 : b;
+    return make_rgb(out_r, out_g, out_b);
+}
+
+static inline unsigned char sharpen_core(const unsigned char *t, const unsigned char *m, const unsigned char *b) {
+    // Apply sharpen kernel to each channel separately
+    // 5×center - neighbors creates edge enhancement
+    int r = get_red(m[1]) * 5
+            - get_red(t[1])     // up
+            - get_red(b[1])     // down
+            - get_red(m[0])     // left
+            - get_red(m[2]);    // right
+
+    int g = get_green(m[1]) * 5
+            - get_green(t[1])
+            - get_green(b[1])
+            - get_green(m[0])
+            - get_green(m[2]);
+
+    int bl = get_blue(m[1]) * 5
+            - get_blue(t[1])
+            - get_blue(b[1])
+            - get_blue(m[0])
+            - get_blue(m[2]);
+
+    return sharpen_pack(r, g, bl);
+}
+
+/* Sliding-window row: moving one pixel right shares most of the window, so each step
+ * loads only the new column x+1 (three pixels) and keeps the decoded centres of columns
+ * x-1 and x and the up+down sum of column x. All three channels are handled at once in
+ * lanes; LANE_BIAS keeps every lane positive (>= 32 - 28) while the taps are subtracted.
+ */
+static void sharpen_row(const unsigned char *t, const unsigned char *m, const unsigned char *b, volatile unsigned char *out) {
+    lanes_init();
+    out[0] = edge_px_3x3(t, m, b, 0, sharpen_core);
+
+    unsigned int ml = lane_decode[m[0]];
+    unsigned int mc = lane_decode[m[1]];
+    unsigned int vc = lane_decode[t[1]] + lane_decode[b[1]];
+    for (int x = 1; x < RES_X - 1; ++x) {
+        unsigned int mn = lane_decode[m[x + 1]];
+        unsigned int v = (mc << 2) + mc + LANE_BIAS - vc - ml - mn;
+        out[x] = sharpen_clamp[0][v & LANE_MASK_SH]
+               | sharpen_clamp[1][(v >> LANE_G_SHIFT) & LANE_MASK_SH]
+               | sharpen_clamp[2][(v >> LANE_B_SHIFT) & LANE_MASK_SH];
+        ml = mc;
+        mc = mn;
+        vc = lane_decode[t[x + 1]] + lane_decode[b[x + 1]];
+    }
+
+    out[RES_X - 1] = edge_px_3x3(t, m, b, RES_X - 1, sharpen_core);
+}
+
 void ip_sharpen3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
     if (!dst) return;
-    for (int y = 0; y < RES_Y; ++y) {
-        for (int x = 0; x < RES_X; ++x) {
-            // Extract color components from center pixel
-            unsigned char center_r = get_red(pixel_at(src, y, x));
-            unsigned char center_g = get_green(pixel_at(src, y, x));
-            unsigned char center_b = get_blue(pixel_at(src, y, x));
-            
-            // Apply sharpen kernel to each channel separately
-            // 5×center - neighbors creates edge enhancement
-            int r = center_r * 5 
-                    - get_red(pixel_at(src, y - 1, x))   // up
-                    - get_red(pixel_at(src, y + 1, x))   // down
-                    - get_red(pixel_at(src, y, x - 1))   // left
-                    - get_red(pixel_at(src, y, x + 1));  // right
-            
-            int g = center_g * 5 
-                    - get_green(pixel_at(src, y - 1, x))
-                    - get_green(pixel_at(src, y + 1, x))
-                    - get_green(pixel_at(src, y, x - 1))
-                    - get_green(pixel_at(src, y, x + 1));
-            
-            int b = center_b * 5 
-                    - get_blue(pixel_at(src, y - 1, x))
-                    - get_blue(pixel_at(src, y + 1, x))
-                    - get_blue(pixel_at(src, y, x - 1))
-                    - get_blue(pixel_at(src, y, x + 1));
-            
-            // Clamp each channel to its valid range (R:0-7, G:0-7, B:0-3)
-            unsigned char out_r = (r < 0) ? 0 : (r > 7) ? 7 : r;
-            unsigned char out_g = (g < 0) ? 0 : (g > 7) ? 7 : g;
-            unsigned char out_b = (b < 0) ? 0 : (b > 3) ? 3 : b;
-            
-            dst_write(dst, y, x, make_rgb(out_r, out_g, out_b));
-        }
-    }
+    run_3x3(src, dst, sharpen_row);
 }
 
 /* 7) Sobel Edge Detection - Gradient-based edge finder
@@ -230,73 +507,1914 @@ void ip_sharpen3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char
  * Effect: Highlights regions of rapid intensity change (edges)
  * Bright pixels indicate strong edges, dark pixels indicate flat regions
  */
+// |Gx| + |Gy| per channel, normalized and clamped, packed to 3-2-2
+static inline unsigned char sobel_pack(int gx_r, int gy_r, int gx_g, int gy_g, int gx_b, int gy_b) {
+    // Calculate approximate magnitude: |Gx| + |Gy|
+    // Faster than true magnitude sqrt(Gx² + Gy²), good for real-time
+    int mag_r = (gx_r < 0 ? -gx_r : gx_r) + (gy_r < 0 ? -gy_r : gy_r);
+    int mag_g = (gx_g < 0 ? -gx_g : gx_g) + (gy_g < 0 ? -gy_g : gy_g);
+    int mag_b = (gx_b < 0 ? -gx_b : gx_b) + (gy_b < 0 ? -gy_b : gy_b);
+
+    // Normalize: divide by 8 to scale from theoretical max 2040 to 0-255 range
+    mag_r = mag_r / 8;
+    mag_g = mag_g / 8;
+    mag_b = mag_b / 8;
+
+    // Clamp to each channel's valid range
+    unsigned char out_r = (mag_r > 7) ? 7 : mag_r;
+    unsigned char out_g = (mag_g > 7) ? 7 : mag_g;
+    unsigned char out_b = (mag_b > 3) ? 3 : mag_b;
+
+    // Reconstruct final edge-detected pixel
+    return make_rgb(out_r, out_g, out_b);
+}
+
+static inline unsigned char sobel_core(const unsigned char *t, const unsigned char *m, const unsigned char *b) {
+    // Extract color components for the 3x3 neighborhood
+    // Naming: p[row][column]_[channel], e.g., p00_r = top-left red
+    int p00_r = get_red(t[0]),   p00_g = get_green(t[0]), p00_b = get_blue(t[0]);  // top-left
+    int p01_r = get_red(t[1]),   p01_g = get_green(t[1]), p01_b = get_blue(t[1]);  // top
+    int p02_r = get_red(t[2]),   p02_g = get_green(t[2]), p02_b = get_blue(t[2]);  // top-right
+    int p10_r = get_red(m[0]),   p10_g = get_green(m[0]), p10_b = get_blue(m[0]);  // left
+    int p12_r = get_red(m[2]),   p12_g = get_green(m[2]), p12_b = get_blue(m[2]);  // right
+    int p20_r = get_red(b[0]),   p20_g = get_green(b[0]), p20_b = get_blue(b[0]);  // bottom-left
+    int p21_r = get_red(b[1]),   p21_g = get_green(b[1]), p21_b = get_blue(b[1]);  // bottom
+    int p22_r = get_red(b[2]),   p22_g = get_green(b[2]), p22_b = get_blue(b[2]);  // bottom-right
+
+    // Apply Sobel kernels to each color channel
+    // Gx detects horizontal edges, Gy detects vertical edges
+    int gx_r = -p00_r + p02_r - 2*p10_r + 2*p12_r - p20_r + p22_r;
+    int gy_r = -p00_r - 2*p01_r - p02_r + p20_r + 2*p21_r + p22_r;
+
+    int gx_g = -p00_g + p02_g - 2*p10_g + 2*p12_g - p20_g + p22_g;
+    int gy_g = -p00_g - 2*p01_g - p02_g + p20_g + 2*p21_g + p22_g;
+
+    int gx_b = -p00_b + p02_b - 2*p10_b + 2*p12_b - p20_b + p22_b;
+    int gy_b = -p00_b - 2*p01_b - p02_b + p20_b + 2*p21_b + p22_b;
+
+    return sobel_pack(gx_r, gy_r, gx_g, gy_g, gx_b, gy_b);
+}
+
+/* Sliding-window row. Both Sobel kernels are separable:
+ *   Gx = s(x+1) - s(x-1)            with s = up + 2*centre + down  (vertical smoothing)
+ *   Gy = d(x-1) + 2*d(x) + d(x+1)   with d = down - up             (vertical difference)
+ * so each step loads only the new column x+1 and keeps s, up and down of columns x-1 and x
+ * as lane words: 3 loads per pixel instead of 8, one add per tap for all channels.
+ * Gx and Gy are biased by LANE_BIAS (lanes stay in 4..60); |.| and /8 are table lookups.
+ */
+static void sobel_row(const unsigned char *t, const unsigned char *m, const unsigned char *b, volatile unsigned char *out) {
+    lanes_init();
+    out[0] = edge_px_3x3(t, m, b, 0, sobel_core);
+
+    // Column x-1 (suffix a) and column x (suffix c)
+    unsigned int ta = lane_decode[t[0]], ba = lane_decode[b[0]];
+    unsigned int sa = ta + (lane_decode[m[0]] << 1) + ba;
+    unsigned int tc = lane_decode[t[1]], bc = lane_decode[b[1]];
+    unsigned int sc = tc + (lane_decode[m[1]] << 1) + bc;
+
+    for (int x = 1; x < RES_X - 1; ++x) {
+        unsigned int tn = lane_decode[t[x + 1]], bn = lane_decode[b[x + 1]];
+        unsigned int sn = tn + (lane_decode[m[x + 1]] << 1) + bn;
+
+        unsigned int gx = LANE_BIAS + sn - sa;
+        unsigned int gy = LANE_BIAS + (ba + (bc << 1) + bn) - (ta + (tc << 1) + tn);
+
+        out[x] = sobel_norm[0][sobel_abs[gx & LANE_MASK] + sobel_abs[gy & LANE_MASK]]
+               | sobel_norm[1][sobel_abs[(gx >> LANE_G_SHIFT) & LANE_MASK] + sobel_abs[(gy >> LANE_G_SHIFT) & LANE_MASK]]
+               | sobel_norm[2][sobel_abs[(gx >> LANE_B_SHIFT) & LANE_MASK] + sobel_abs[(gy >> LANE_B_SHIFT) & LANE_MASK]];
+
+        ta = tc; ba = bc; sa = sc;
+        tc = tn; bc = bn; sc = sn;
+    }
+
+    out[RES_X - 1] = edge_px_3x3(t, m, b, RES_X - 1, sobel_core);
+}
+
 void ip_sobel(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
     if (!dst) return;
+    run_3x3(src, dst, sobel_row);
+}
+
+/* 8) Chamfer distance transform (3-4)
+ * Distance from every pixel to the nearest feature pixel, with steps of 3 along rows and
+ * columns and 4 along diagonals (about 3x the Euclidean distance). A forward raster pass
+ * takes the minimum over the left and upper neighbours, a backward pass over the right
+ * and lower ones; both read the 16-bit buffer sequentially. Pixels outside the image
+ * never contribute.
+ */
+#define CHAMFER_INF 0x7FFF  // no feature yet; +4 still fits in 16 bits
+
+static inline void chamfer_min(unsigned short *d, unsigned int v) {
+    if (v < *d) *d = v;
+}
+
+void ip_chamfer(const unsigned char src[RES_Y][RES_X], unsigned short dist[RES_Y][RES_X], int features_white) {
+    for (int y = 0; y < RES_Y; ++y)
+        for (int x = 0; x < RES_X; ++x)
+            dist[y][x] = ((src[y][x] >= BW_THRESHOLD) == (features_white != 0)) ? 0 : CHAMFER_INF;
+
+    for (int y = 0; y < RES_Y; ++y) {
+        unsigned short *row = dist[y];
+        const unsigned short *up = (y > 0) ? dist[y - 1] : 0;
+        for (int x = 0; x < RES_X; ++x) {
+            if (x > 0) chamfer_min(&row[x], row[x - 1] + 3);
+            if (up) {
+                chamfer_min(&row[x], up[x] + 3);
+                if (x > 0)         chamfer_min(&row[x], up[x - 1] + 4);
+                if (x < RES_X - 1) chamfer_min(&row[x], up[x + 1] + 4);
+            }
+        }
+    }
+    for (int y = RES_Y - 1; y >= 0; --y) {
+        unsigned short *row = dist[y];
+        const unsigned short *down = (y < RES_Y - 1) ? dist[y + 1] : 0;
+        for (int x = RES_X - 1; x >= 0; --x) {
+            if (x < RES_X - 1) chamfer_min(&row[x], row[x + 1] + 3);
+            if (down) {
+                chamfer_min(&row[x], down[x] + 3);
+                if (x < RES_X - 1) chamfer_min(&row[x], down[x + 1] + 4);
+                if (x > 0)         chamfer_min(&row[x], down[x - 1] + 4);
+            }
+        }
+    }
+}
+
+/* Distance display
+ * Black pixels glow orange, fading over ~14 pixels from the nearest white pixel;
+ * white pixels get brighter towards the middle of their shape (thickness).
+ */
+#define DIST_STEPS 8
+static unsigned short dist_out[RES_Y][RES_X], dist_in[RES_Y][RES_X];
+
+void ip_distance(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    unsigned char glow[DIST_STEPS], core[DIST_STEPS];
+    if (!dst) return;
+    for (int i = 0; i < DIST_STEPS; ++i) {
+        const int g = DIST_STEPS - 1 - i;
+        glow[i] = make_rgb(g, g >> 1, 0);
+        core[i] = make_rgb(i, 1 + (i >> 2), 2 + (i >> 2));
+    }
+    ip_chamfer(src, dist_out, 1);
+    ip_chamfer(src, dist_in, 0);
+
+    for (int y = 0; y < RES_Y; ++y) {
+        volatile unsigned char *out = dst + y * RES_X;
+        for (int x = 0; x < RES_X; ++x) {
+            const int white = dist_out[y][x] == 0;
+            int step = (white ? dist_in[y][x] : dist_out[y][x]) / 6;   // 2 pixels per step
+            if (step >= DIST_STEPS) step = DIST_STEPS - 1;
+            out[x] = white ? core[step] : glow[step];
+        }
+    }
+}
+
+/* Median filter (constant time per pixel, Huang/Perreault style)
+ * Each 3-2-2 channel has only 8 (red) or 4 (green, blue) levels, so a channel histogram
+ * is a few byte-sized bin counts packed into words: red in two words (bins 0-3, 4-7),
+ * green and blue in one word each. A column histogram covers rows y-r..y+r of its column
+ * and moves down one row by removing one pixel and adding one. The window histogram
+ * slides right by adding the entering column and subtracting the leaving one: four word
+ * adds and four word subtracts, whatever the radius. The median bin comes from the byte
+ * prefix sums (w * 0x01010101) and a packed >= compare against the median rank.
+ * Byte counts limit the window to 255 pixels, so radius is clamped to IP_MEDIAN_MAX_RADIUS.
+ */
+typedef struct {
+    unsigned int w[4];  // red bins 0-3, red bins 4-7, green bins 0-3, blue bins 0-3
+} median_hist_t;
+
+static median_hist_t median_cols[RES_X + 2 * IP_MEDIAN_MAX_RADIUS];
+
+static inline const unsigned char *row_any(const unsigned char img[RES_Y][RES_X], int y) {
+    return (y < 0 || y >= RES_Y) ? row_at(img, y) : img[y];
+}
+
+static inline void median_add(median_hist_t *h, unsigned char p) {
+    unsigned int r = get_red(p);
+    h->w[r >> 2] += 1u << ((r & 3) * 8);
+    h->w[2] += 1u << (get_green(p) * 8);
+    h->w[3] += 1u << (get_blue(p) * 8);
+}
+
+static inline void median_remove(median_hist_t *h, unsigned char p) {
+    unsigned int r = get_red(p);
+    h->w[r >> 2] -= 1u << ((r & 3) * 8);
+    h->w[2] -= 1u << (get_green(p) * 8);
+    h->w[3] -= 1u << (get_blue(p) * 8);
+}
+
+// Number of bins among the four in 'w' whose prefix sum (plus 'base') reaches 'rank'
+static inline unsigned int median_bins_reached(unsigned int w, unsigned int base, unsigned int rank) {
+    unsigned int ge = swar_ge_mask(w * SWAR_LO + base * SWAR_LO, rank);
+    return ((ge >> 7) * SWAR_LO) >> 24;
+}
+
+static inline unsigned char median_pack(const median_hist_t *h, unsigned int rank) {
+    unsigned int lo_total = (h->w[0] * SWAR_LO) >> 24;
+    unsigned int r = 8 - median_bins_reached(h->w[0], 0, rank) - median_bins_reached(h->w[1], lo_total, rank);
+    unsigned int g = 4 - median_bins_reached(h->w[2], 0, rank);
+    unsigned int b = 4 - median_bins_reached(h->w[3], 0, rank);
+    return make_rgb(r, g, b);
+}
+
+// Pixel of column index i (image column i - rad) in 'row', through col_at() outside the image
+static inline unsigned char median_px(const unsigned char *row, int i, int rad) {
+    int x = i - rad;
+    return (x < 0 || x >= RES_X) ? col_at(row, x) : row[x];
+}
+
+void ip_median(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius) {
+    if (!dst) return;
+    if (radius < 1) radius = 1;
+    if (radius > IP_MEDIAN_MAX_RADIUS) radius = IP_MEDIAN_MAX_RADIUS;
+
+    const int cols = RES_X + 2 * radius;
+    const int size = 2 * radius + 1;
+    const unsigned int rank = (size * size + 1) / 2;
+
+    // Column histograms for row 0
+    for (int i = 0; i < cols; ++i)
+        for (int k = 0; k < 4; ++k) median_cols[i].w[k] = 0;
+    for (int ky = -radius; ky <= radius; ++ky) {
+        const unsigned char *row = row_any(src, ky);
+        for (int i = 0; i < cols; ++i)
+            median_add(&median_cols[i], median_px(row, i, radius));
+    }
+
+    for (int y = 0; y < RES_Y; ++y) {
+        if (y > 0) {
+            // Move every column histogram down one row
+            const unsigned char *out_row = row_any(src, y - radius - 1);
+            const unsigned char *in_row = row_any(src, y + radius);
+            for (int i = 0; i < radius; ++i) {
+                median_remove(&median_cols[i], median_px(out_row, i, radius));
+                median_add(&median_cols[i], median_px(in_row, i, radius));
+            }
+            for (int i = radius; i < radius + RES_X; ++i) {
+                median_remove(&median_cols[i], out_row[i - radius]);
+                median_add(&median_cols[i], in_row[i - radius]);
+            }
+            for (int i = radius + RES_X; i < cols; ++i) {
+                median_remove(&median_cols[i], median_px(out_row, i, radius));
+                median_add(&median_cols[i], median_px(in_row, i, radius));
+            }
+        }
+
+        // Window histogram for x = 0, then slide right
+        median_hist_t h = median_cols[0];
+        for (int i = 1; i < size; ++i)
+            for (int k = 0; k < 4; ++k) h.w[k] += median_cols[i].w[k];
+
+        volatile unsigned char *out = dst + y * RES_X;
+        for (int x = 0; x < RES_X; ++x) {
+            out[x] = median_pack(&h, rank);
+            if (x + 1 < RES_X)
+                for (int k = 0; k < 4; ++k)
+                    h.w[k] += median_cols[x + size].w[k] - median_cols[x].w[k];
+        }
+    }
+}
+
+void ip_median3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    ip_median(src, dst, 1);
+}
+
+void ip_median5x5(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    ip_median(src, dst, 2);
+}
+
+/* Box blur of any radius with running sums
+ * Separable: per column a vertical running sum over rows y-r..y+r moves down by adding the
+ * entering row and subtracting the leaving one, and per row a horizontal running sum over
+ * those column sums slides right the same way. Each output pixel costs the same few
+ * operations for any radius. Vertical sums stay below 7 * 31 and live in the 10-bit lanes
+ * of lane_decode[]; horizontal sums (up to 7 * 31 * 31) are kept per channel, and the
+ * divide by (2r+1)^2 is a multiply by a 24-bit reciprocal.
+ */
+static unsigned int box_cols[RES_X + 2 * IP_BOX_MAX_RADIUS];  // lane column sums, index x + r
+static unsigned char box_row[RES_X + 2 * IP_BOX_MAX_RADIUS];  // scratch row for the Gaussian passes
+
+// floor(s / d) == (s * recip24(d)) >> 24 as long as s * d < 2^24 and s * recip24(d) < 2^32
+static inline unsigned int recip24(unsigned int d) {
+    return (1u << 24) / d + 1;
+}
+
+static inline int clamp_radius(int radius) {
+    if (radius < 1) return 1;
+    if (radius > IP_BOX_MAX_RADIUS) return IP_BOX_MAX_RADIUS;
+    return radius;
+}
+
+// Add (sign 1) or remove (sign -1) one image row to the column sums
+static void box_cols_update(const unsigned char *row, int rad, int sign) {
+    const int cols = RES_X + 2 * rad;
+    for (int i = 0; i < rad; ++i)
+        box_cols[i] += sign * lane_decode[col_at(row, i - rad)];
+    for (int i = rad; i < rad + RES_X; ++i)
+        box_cols[i] += sign * lane_decode[row[i - rad]];
+    for (int i = rad + RES_X; i < cols; ++i)
+        box_cols[i] += sign * lane_decode[col_at(row, i - rad)];
+}
+
+void ip_box_blur(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius) {
+    if (!dst) return;
+    lanes_init();
+    const int rad = clamp_radius(radius);
+    const int size = 2 * rad + 1;
+    const int cols = RES_X + 2 * rad;
+    const unsigned int recip = recip24(size * size);
+
+    for (int i = 0; i < cols; ++i) box_cols[i] = 0;
+    for (int ky = -rad; ky <= rad; ++ky)
+        box_cols_update(row_any(src, ky), rad, 1);
+
+    for (int y = 0; y < RES_Y; ++y) {
+        if (y > 0) {
+            box_cols_update(row_any(src, y - rad - 1), rad, -1);
+            box_cols_update(row_any(src, y + rad), rad, 1);
+        }
+
+        unsigned int hr = 0, hg = 0, hb = 0;
+        for (int i = 0; i < size; ++i) {
+            unsigned int c = box_cols[i];
+            hr += c & 0x3FF;
+            hg += (c >> LANE_G_SHIFT) & 0x3FF;
+            hb += (c >> LANE_B_SHIFT) & 0x3FF;
+        }
+
+        volatile unsigned char *out = dst + y * RES_X;
+        for (int x = 0; x < RES_X; ++x) {
+            out[x] = make_rgb((hr * recip) >> 24, (hg * recip) >> 24, (hb * recip) >> 24);
+            if (x + 1 < RES_X) {
+                // Entering minus leaving column, biased by 512 per lane so no lane borrows
+                unsigned int d = box_cols[x + size] + 512 * LANE_ONES - box_cols[x];
+                hr += (d & 0x3FF) - 512;
+                hg += ((d >> LANE_G_SHIFT) & 0x3FF) - 512;
+                hb += ((d >> LANE_B_SHIFT) & 0x3FF) - 512;
+            }
+        }
+    }
+}
+
+/* Approximate Gaussian: three stacked box passes of radius r
+ * Works on planes scaled by 32 (5 fractional bits) so the repeated averaging does not
+ * wash out the 2- and 3-bit channels. The three horizontal passes run row by row in place,
+ * ping-ponging between the row and one shared scratch row buffer; the three vertical
+ * passes alternate between two plane buffers with one running sum per column.
+ */
+#define GAUSS_FRAC 5
+
+static ip_planar_t gauss_planes[2];
+static unsigned int gauss_vsum[RES_X];
+
+// One horizontal box pass: 'in' (scratch, padded by rad on each side) -> 'out'
+static void gauss_box_row(const unsigned char *in, unsigned char *out, int rad, unsigned int recip) {
+    const int size = 2 * rad + 1;
+    unsigned int sum = (size >> 1);  // rounding
+    for (int i = 0; i < size; ++i) sum += in[i];
+    for (int x = 0; x < RES_X; ++x) {
+        out[x] = (sum * recip) >> 24;
+        if (x + 1 < RES_X)
+            sum += in[x + size] - in[x];
+    }
+}
+
+static void gauss_pad_row(const unsigned char *row, int rad) {
+    for (int i = 0; i < RES_X + 2 * rad; ++i)
+        box_row[i] = col_at(row, i - rad);
+}
+
+static void gauss_box_h(unsigned char plane[RES_Y][RES_X], int rad, unsigned int recip) {
+    for (int y = 0; y < RES_Y; ++y)
+        for (int pass = 0; pass < 3; ++pass) {
+            gauss_pad_row(plane[y], rad);
+            gauss_box_row(box_row, plane[y], rad, recip);
+        }
+}
+
+static void gauss_box_v(unsigned char in[RES_Y][RES_X], unsigned char out[RES_Y][RES_X], int rad, unsigned int recip) {
+    for (int x = 0; x < RES_X; ++x) gauss_vsum[x] = rad;  // rounding, (2r+1)/2 == r
+    for (int ky = -rad; ky <= rad; ++ky) {
+        const unsigned char *row = row_any(in, ky);
+        for (int x = 0; x < RES_X; ++x) gauss_vsum[x] += row[x];
+    }
     for (int y = 0; y < RES_Y; ++y) {
+        const unsigned char *leave = row_any(in, y - rad);
+        const unsigned char *enter = row_any(in, y + rad + 1);
+        for (int x = 0; x < RES_X; ++x) {
+            out[y][x] = (gauss_vsum[x] * recip) >> 24;
+            gauss_vsum[x] += enter[x] - leave[x];
+        }
+    }
+}
+
+void ip_gaussian_approx(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius) {
+    if (!dst) return;
+    const int rad = clamp_radius(radius);
+    const unsigned int recip = recip24(2 * rad + 1);
+    ip_planar_t *a = &gauss_planes[0], *b = &gauss_planes[1];
+
+    for (int y = 0; y < RES_Y; ++y)
         for (int x = 0; x < RES_X; ++x) {
-            // Extract color components for the 3x3 neighborhood
-            // Naming: p[row][column]_[channel], e.g., p00_r = top-left red
-            int p00_r = get_red(pixel_at(src, y - 1, x - 1));
-            int p00_g = get_green(pixel_at(src, y - 1, x - 1));
-            int p00_b = get_blue(pixel_at(src, y - 1, x - 1));
-            
-            int p01_r = get_red(pixel_at(src, y - 1, x));      // top
-            int p01_g = get_green(pixel_at(src, y - 1, x));
-            int p01_b = get_blue(pixel_at(src, y - 1, x));
-            
-            int p02_r = get_red(pixel_at(src, y - 1, x + 1));  // top-right
-            int p02_g = get_green(pixel_at(src, y - 1, x + 1));
-            int p02_b = get_blue(pixel_at(src, y - 1, x + 1));
-            
-            int p10_r = get_red(pixel_at(src, y, x - 1));      // left
-            int p10_g = get_green(pixel_at(src, y, x - 1));
-            int p10_b = get_blue(pixel_at(src, y, x - 1));
-            
-            int p12_r = get_red(pixel_at(src, y, x + 1));      // right
-            int p12_g = get_green(pixel_at(src, y, x + 1));
-            int p12_b = get_blue(pixel_at(src, y, x + 1));
-            
-            int p20_r = get_red(pixel_at(src, y + 1, x - 1));  // bottom-left
-            int p20_g = get_green(pixel_at(src, y + 1, x - 1));
-            int p20_b = get_blue(pixel_at(src, y + 1, x - 1));
-            
-            int p21_r = get_red(pixel_at(src, y + 1, x));      // bottom
-            int p21_g = get_green(pixel_at(src, y + 1, x));
-            int p21_b = get_blue(pixel_at(src, y + 1, x));
-            
-            int p22_r = get_red(pixel_at(src, y + 1, x + 1));  // bottom-right
-            int p22_g = get_green(pixel_at(src, y + 1, x + 1));
-            int p22_b = get_blue(pixel_at(src, y + 1, x + 1));
-            
-            // Apply Sobel kernels to each color channel
-            // Gx detects horizontal edges, Gy detects vertical edges
-            int gx_r = -p00_r + p02_r - 2*p10_r + 2*p12_r - p20_r + p22_r;
-            int gy_r = -p00_r - 2*p01_r - p02_r + p20_r + 2*p21_r + p22_r;
-            
-            int gx_g = -p00_g + p02_g - 2*p10_g + 2*p12_g - p20_g + p22_g;
-            int gy_g = -p00_g - 2*p01_g - p02_g + p20_g + 2*p21_g + p22_g;
-            
-            int gx_b = -p00_b + p02_b - 2*p10_b + 2*p12_b - p20_b + p22_b;
-            int gy_b = -p00_b - 2*p01_b - p02_b + p20_b + 2*p21_b + p22_b;
-            
-            // Calculate approximate magnitude: |Gx| + |Gy|
-            // Faster than true magnitude sqrt(Gx² + Gy²), good for real-time
-            int mag_r = (gx_r < 0 ? -gx_r : gx_r) + (gy_r < 0 ? -gy_r : gy_r);
-            int mag_g = (gx_g < 0 ? -gx_g : gx_g) + (gy_g < 0 ? -gy_g : gy_g);
-            int mag_b = (gx_b < 0 ? -gx_b : gx_b) + (gy_b < 0 ? -gy_b : gy_b);
-            
-            // Normalize: divide by 8 to scale from theoretical max 2040 to 0-255 range
-            mag_r = mag_r / 8;
-            mag_g = mag_g / 8;
-            mag_b = mag_b / 8;
-            
-            // Clamp to each channel's valid range
-            unsigned char out_r = (mag_r > 7) ? 7 : mag_r;
-            unsigned char out_g = (mag_g > 7) ? 7 : mag_g;
-            unsigned char out_b = (mag_b > 3) ? 3 : mag_b;
-            
-            // Reconstruct final edge-detected pixel
-            dst_write(dst, y, x, make_rgb(out_r, out_g, out_b));
-        }
-    }
-}
\ No newline at end of file
+            unsigned char s = src[y][x];
+            a->r[y][x] = get_red(s) << GAUSS_FRAC;
+            a->g[y][x] = get_green(s) << GAUSS_FRAC;
+            a->b[y][x] = get_blue(s) << GAUSS_FRAC;
+        }
+
+    unsigned char (*pa[3])[RES_X] = { a->r, a->g, a->b };
+    unsigned char (*pb[3])[RES_X] = { b->r, b->g, b->b };
+    for (int c = 0; c < 3; ++c) {
+        gauss_box_h(pa[c], rad, recip);
+        gauss_box_v(pa[c], pb[c], rad, recip);
+        gauss_box_v(pb[c], pa[c], rad, recip);
+        gauss_box_v(pa[c], pb[c], rad, recip);
+    }
+
+    const int half = 1 << (GAUSS_FRAC - 1);
+    for (int y = 0; y < RES_Y; ++y)
+        for (int x = 0; x < RES_X; ++x)
+            dst_write(dst, y, x, make_rgb((b->r[y][x] + half) >> GAUSS_FRAC,
+                                          (b->g[y][x] + half) >> GAUSS_FRAC,
+                                          (b->b[y][x] + half) >> GAUSS_FRAC));
+}
+
+/* Unsharp mask
+ * out = orig + amount * (orig - blurred) per channel, amount in 1/IP_UNSHARP_ONE steps,
+ * rounded and clamped. The result only depends on the two pixel values, so it is a
+ * 128 x 128 table (bit 0 unused) rebuilt when the amount changes, and the pass over
+ * the image is one lookup per pixel. The blurred copy comes from ip_box_blur.
+ */
+static unsigned char usm_table[128][128];
+static int usm_amount = -1;
+
+static inline int usm_channel(int o, int b, int amount, int max) {
+    const int d = amount * (o - b);
+    // Round half away from zero so dark and bright sides of an edge move alike
+    const int q = (((d >= 0) ? d : -d) + IP_UNSHARP_ONE / 2) / IP_UNSHARP_ONE;
+    const int v = o + ((d >= 0) ? q : -q);
+    return (v < 0) ? 0 : (v > max) ? max : v;
+}
+
+void ip_unsharp_apply(const unsigned char src[RES_Y][RES_X], const unsigned char blurred[RES_Y][RES_X],
+                      volatile unsigned char *dst, int amount) {
+    if (!dst) return;
+    if (amount != usm_amount) {
+        for (int o = 0; o < 128; ++o)
+            for (int b = 0; b < 128; ++b) {
+                const unsigned char po = o << 1, pb = b << 1;
+                usm_table[o][b] = make_rgb(usm_channel(get_red(po), get_red(pb), amount, 7),
+                                           usm_channel(get_green(po), get_green(pb), amount, 3),
+                                           usm_channel(get_blue(po), get_blue(pb), amount, 3));
+            }
+        usm_amount = amount;
+    }
+    for (int y = 0; y < RES_Y; ++y) {
+        const unsigned char *o = src[y], *b = blurred[y];
+        volatile unsigned char *out = dst + y * RES_X;
+        for (int x = 0; x < RES_X; ++x)
+            out[x] = usm_table[o[x] >> 1][b[x] >> 1];
+    }
+}
+
+/* Integral image of luma
+ * sum[y][x] holds the luma total of all pixels above and left of (x, y), with a zero
+ * first row and column so any rectangle sum is four loads and no edge tests. The
+ * largest total is 255 * 320 * 240 < 2^25, so 32 bits never overflow.
+ */
+static unsigned char luma_px(unsigned char p) {
+    // Channels expanded to 0-255, then BT.601 weights in 8.8 fixed point
+    return (77 * (get_red(p) * 255 / 7) + 150 * (get_green(p) * 85) + 29 * (get_blue(p) * 85)) >> 8;
+}
+
+static const unsigned char *luma_table(void) {
+    static unsigned char lut[256];
+    static int built = 0;
+    if (!built) {
+        for (int i = 0; i < 256; ++i)
+            lut[i] = luma_px((unsigned char)i);
+        built = 1;
+    }
+    return lut;
+}
+
+void ip_integral_build(const unsigned char src[RES_Y][RES_X], ip_integral_t *ii) {
+    const unsigned char *luma = luma_table();
+    for (int x = 0; x <= RES_X; ++x) ii->sum[0][x] = 0;
+    for (int y = 0; y < RES_Y; ++y) {
+        const unsigned int *above = ii->sum[y];
+        unsigned int *out = ii->sum[y + 1];
+        unsigned int row = 0;
+        out[0] = 0;
+        for (int x = 0; x < RES_X; ++x) {
+            row += luma[src[y][x]];
+            out[x + 1] = above[x + 1] + row;
+        }
+    }
+}
+
+unsigned int ip_integral_mean(const ip_integral_t *ii, int cx, int cy, int radius) {
+    int x0 = cx - radius, y0 = cy - radius, x1 = cx + radius + 1, y1 = cy + radius + 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > RES_X) x1 = RES_X;
+    if (y1 > RES_Y) y1 = RES_Y;
+    return ip_integral_rect(ii, x0, y0, x1, y1) / ((x1 - x0) * (y1 - y0));
+}
+
+/* Adaptive threshold (Bradley-Roth)
+ * A pixel turns white when its luma is above (100 - percent)% of the mean luma of the
+ * (2r+1)^2 window around it, clipped to the image. The test is cross-multiplied,
+ * luma * count * 100 > sum * (100 - percent), so there is no divide per pixel.
+ * Products stay below 255 * 61^2 * 100 < 2^27 for r up to IP_ADAPTIVE_MAX_RADIUS.
+ */
+void ip_adaptive_threshold(const ip_integral_t *ii, const unsigned char src[RES_Y][RES_X],
+                           volatile unsigned char *dst, int radius, int percent) {
+    if (!dst) return;
+    const unsigned char *luma = luma_table();
+    if (radius < 1) radius = 1;
+    if (radius > IP_ADAPTIVE_MAX_RADIUS) radius = IP_ADAPTIVE_MAX_RADIUS;
+    const unsigned int keep = 100 - percent;
+
+    for (int y = 0; y < RES_Y; ++y) {
+        int y0 = y - radius, y1 = y + radius + 1;
+        if (y0 < 0) y0 = 0;
+        if (y1 > RES_Y) y1 = RES_Y;
+        const unsigned int *top = ii->sum[y0], *bot = ii->sum[y1];
+        const unsigned int h100 = (y1 - y0) * 100;
+        volatile unsigned char *out = dst + y * RES_X;
+
+        for (int x = 0; x < RES_X; ++x) {
+            int x0 = x - radius, x1 = x + radius + 1;
+            if (x0 < 0) x0 = 0;
+            if (x1 > RES_X) x1 = RES_X;
+            unsigned int sum = bot[x1] - bot[x0] - top[x1] + top[x0];
+            unsigned int lhs = luma[src[y][x]] * (x1 - x0) * h100;
+            out[x] = (lhs > sum * keep) ? 255 : 0;
+        }
+    }
+}
+
+/* Image statistics and histogram-driven remap tables
+ * The sweep over the image only bumps one counter per pixel, in a histogram of the raw
+ * 3-2-2 byte; the channel and luma histograms, min, max and means all fold out of those
+ * 256 bins afterwards. Each filter then turns the statistics into a 256-entry table that
+ * is applied with ip_apply_lut, so the whole filter costs about two point-filter passes.
+ */
+static unsigned int stats_raw[256];
+
+void ip_stats(const unsigned char src[RES_Y][RES_X], ip_stats_t *st) {
+    const unsigned char *luma = luma_table();
+    for (int i = 0; i < 256; ++i) stats_raw[i] = 0;
+    for (int y = 0; y < RES_Y; ++y) {
+        const unsigned char *row = src[y];
+        for (int x = 0; x < RES_X; ++x)
+            stats_raw[row[x]]++;
+    }
+
+    for (int i = 0; i < 8; ++i) st->hist_r[i] = 0;
+    for (int i = 0; i < 4; ++i) st->hist_g[i] = st->hist_b[i] = 0;
+    for (int i = 0; i < 256; ++i) st->hist_luma[i] = 0;
+    for (int p = 0; p < 256; ++p) {
+        unsigned int n = stats_raw[p];
+        st->hist_r[get_red(p)] += n;
+        st->hist_g[get_green(p)] += n;
+        st->hist_b[get_blue(p)] += n;
+        st->hist_luma[luma[p]] += n;
+    }
+
+    const unsigned int *hists[IP_STATS_CHANNELS] = { st->hist_r, st->hist_g, st->hist_b, st->hist_luma };
+    static const int bins[IP_STATS_CHANNELS] = { 8, 4, 4, 256 };
+    for (int c = 0; c < IP_STATS_CHANNELS; ++c) {
+        unsigned int sum = 0;
+        int lo = -1, hi = 0;
+        for (int v = 0; v < bins[c]; ++v) {
+            if (!hists[c][v]) continue;
+            if (lo < 0) lo = v;
+            hi = v;
+            sum += hists[c][v] * v;
+        }
+        st->min[c] = (lo < 0) ? 0 : lo;
+        st->max[c] = hi;
+        // 8.8 fixed point; split so sum * 256 cannot overflow for luma
+        const unsigned int total = RES_X * RES_Y;
+        st->mean[c] = (sum / total) * 256 + ((sum % total) * 256 + total / 2) / total;
+    }
+}
+
+// Table from one remap per channel
+static void stats_channel_table(const unsigned char map_r[8], const unsigned char map_g[4],
+                                const unsigned char map_b[4], unsigned char lut[256]) {
+    for (int p = 0; p < 256; ++p)
+        lut[p] = make_rgb(map_r[get_red(p)], map_g[get_green(p)], map_b[get_blue(p)]);
+}
+
+/* Auto-levels: stretch each channel's [min, max] to its full range, rounded */
+static void levels_map(unsigned char lo, unsigned char hi, int levels, unsigned char *map) {
+    const int top = levels - 1;
+    for (int v = 0; v < levels; ++v) {
+        if (hi <= lo)       map[v] = v;
+        else if (v <= lo)   map[v] = 0;
+        else if (v >= hi)   map[v] = top;
+        else                map[v] = ((v - lo) * top * 2 + (hi - lo)) / (2 * (hi - lo));
+    }
+}
+
+void ip_autolevels_table(const ip_stats_t *st, unsigned char lut[256]) {
+    unsigned char map_r[8], map_g[4], map_b[4];
+    levels_map(st->min[IP_STATS_R], st->max[IP_STATS_R], 8, map_r);
+    levels_map(st->min[IP_STATS_G], st->max[IP_STATS_G], 4, map_g);
+    levels_map(st->min[IP_STATS_B], st->max[IP_STATS_B], 4, map_b);
+    stats_channel_table(map_r, map_g, map_b, lut);
+}
+
+/* Histogram equalization per channel
+ * out = round((cdf(v) - cdf(min)) * top / (N - cdf(min))), where cdf is inclusive
+ */
+static void equalize_map(const unsigned int *hist, int levels, unsigned char *map) {
+    const unsigned int total = RES_X * RES_Y;
+    const int top = levels - 1;
+    unsigned int cdf = 0, cmin = 0;
+    for (int v = 0; v < levels; ++v) {
+        cdf += hist[v];
+        if (!cmin) cmin = cdf;
+        if (total == cmin) map[v] = v;
+        else               map[v] = ((cdf - cmin) * top * 2 + (total - cmin)) / (2 * (total - cmin));
+    }
+}
+
+void ip_equalize_table(const ip_stats_t *st, unsigned char lut[256]) {
+    unsigned char map_r[8], map_g[4], map_b[4];
+    equalize_map(st->hist_r, 8, map_r);
+    equalize_map(st->hist_g, 4, map_g);
+    equalize_map(st->hist_b, 4, map_b);
+    stats_channel_table(map_r, map_g, map_b, lut);
+}
+
+/* Otsu threshold on the luma histogram
+ * Picks t maximizing the between-class variance wB * wF * (mB - mF)^2. Class means are
+ * kept with 4 fractional bits; the product needs 64 bits but only multiplies, no divides.
+ */
+int ip_otsu_level(const ip_stats_t *st) {
+    const unsigned int total = RES_X * RES_Y;
+    unsigned int sum_all = 0;
+    for (int v = 0; v < 256; ++v) sum_all += st->hist_luma[v] * v;
+
+    unsigned int w_b = 0, sum_b = 0;
+    unsigned long long best = 0;
+    int level = 0;
+    for (int t = 0; t < 255; ++t) {
+        w_b += st->hist_luma[t];
+        sum_b += st->hist_luma[t] * t;
+        if (!w_b) continue;
+        const unsigned int w_f = total - w_b;
+        if (!w_f) break;
+        const int m_b = (sum_b << 4) / w_b;
+        const int m_f = ((sum_all - sum_b) << 4) / w_f;
+        const unsigned int d = (m_f - m_b) * (m_f - m_b);
+        const unsigned long long var = (unsigned long long)w_b * w_f * d;
+        if (var > best) {
+            best = var;
+            level = t;
+        }
+    }
+    return level;
+}
+
+void ip_otsu_table(const ip_stats_t *st, unsigned char lut[256]) {
+    const unsigned char *luma = luma_table();
+    const int level = ip_otsu_level(st);
+    for (int p = 0; p < 256; ++p)
+        lut[p] = (luma[p] > level) ? 255 : 0;
+}
+
+// Define the full-frame filter for one statistics-driven table
+#define IP_STATS_FILTER(name)                                                               \
+    void ip_##name(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {    \
+        static ip_stats_t st;                                                               \
+        unsigned char lut[256];                                                             \
+        ip_stats(src, &st);                                                                 \
+        ip_##name##_table(&st, lut);                                                        \
+        ip_apply_lut(src, dst, lut);                                                        \
+    }
+
+IP_STATS_FILTER(autolevels)
+IP_STATS_FILTER(equalize)
+IP_STATS_FILTER(otsu)
+
+/* Contrast-limited adaptive histogram equalization (CLAHE)
+ * The frame is cut into IP_CLAHE_TILE-square tiles. Each tile gets per-channel histograms
+ * clipped at IP_CLAHE_CLIP times the mean bin count (the excess is spread over all bins)
+ * and a 256-entry table mapping a pixel to its equalized channels at 4-bit precision,
+ * packed in the 10-bit lanes. Every output pixel blends the tables of the four nearest
+ * tile centres: horizontally in the lanes with 6-bit weights that step along the row
+ * in 16.16 fixed point, then vertically with a 4-bit weight fixed for the whole row.
+ */
+#define CLAHE_TILES_X (RES_X / IP_CLAHE_TILE)
+#define CLAHE_TILES_Y (RES_Y / IP_CLAHE_TILE)
+#define CLAHE_HALF    (IP_CLAHE_TILE / 2)
+#define CLAHE_WX      64   // horizontal weight scale
+#define CLAHE_WY      16   // vertical weight scale
+#define LANE_MASK6    (0x3Fu | (0x3Fu << LANE_G_SHIFT) | (0x3Fu << LANE_B_SHIFT))
+
+static unsigned int clahe_lut[CLAHE_TILES_Y][CLAHE_TILES_X][256];
+static unsigned char clahe_out_r[16], clahe_out_g[16], clahe_out_b[16];
+
+// Clip, redistribute and integrate one channel histogram into a 0-15 map
+static void clahe_map(unsigned int *hist, int levels, unsigned char *map) {
+    const unsigned int total = IP_CLAHE_TILE * IP_CLAHE_TILE;
+    const unsigned int clip = IP_CLAHE_CLIP * total / levels;
+    unsigned int excess = 0;
+    for (int v = 0; v < levels; ++v)
+        if (hist[v] > clip) {
+            excess += hist[v] - clip;
+            hist[v] = clip;
+        }
+    unsigned int cdf = 0;
+    for (int v = 0; v < levels; ++v) {
+        cdf += hist[v] + excess / levels + ((unsigned int)v < excess % levels);
+        map[v] = (cdf * 15 + total / 2) / total;
+    }
+}
+
+static void clahe_tile(const unsigned char src[RES_Y][RES_X], int ty, int tx) {
+    unsigned int raw[256];
+    unsigned int hist_r[8], hist_g[4], hist_b[4];
+    unsigned char map_r[8], map_g[4], map_b[4];
+
+    for (int i = 0; i < 256; ++i) raw[i] = 0;
+    for (int i = 0; i < 8; ++i) hist_r[i] = 0;
+    for (int i = 0; i < 4; ++i) hist_g[i] = hist_b[i] = 0;
+    for (int y = 0; y < IP_CLAHE_TILE; ++y) {
+        const unsigned char *row = src[ty * IP_CLAHE_TILE + y] + tx * IP_CLAHE_TILE;
+        for (int x = 0; x < IP_CLAHE_TILE; ++x)
+            raw[row[x]]++;
+    }
+    for (int p = 0; p < 256; ++p) {
+        hist_r[get_red(p)] += raw[p];
+        hist_g[get_green(p)] += raw[p];
+        hist_b[get_blue(p)] += raw[p];
+    }
+    clahe_map(hist_r, 8, map_r);
+    clahe_map(hist_g, 4, map_g);
+    clahe_map(hist_b, 4, map_b);
+
+    unsigned int *lut = clahe_lut[ty][tx];
+    for (int p = 0; p < 256; ++p)
+        lut[p] = map_r[get_red(p)] | (map_g[get_green(p)] << LANE_G_SHIFT) | (map_b[get_blue(p)] << LANE_B_SHIFT);
+}
+
+// Blend one run of pixels between two tile columns of the row tables 'top' and 'bot'
+static void clahe_span(const unsigned char *in, volatile unsigned char *out, int n,
+                       const unsigned int *t0, const unsigned int *t1,
+                       const unsigned int *b0, const unsigned int *b1, unsigned int wy) {
+    const unsigned int step = (CLAHE_WX << 16) / IP_CLAHE_TILE + 1;
+    unsigned int acc = 0;
+    for (int x = 0; x < n; ++x) {
+        const unsigned char p = in[x];
+        const unsigned int wx = acc >> 16;
+        // Lanes stay below 15 * 64 + 8, then 60 after the shift, then 60 * 16 + 32
+        unsigned int top = t0[p] * (CLAHE_WX - wx) + t1[p] * wx;
+        unsigned int bot = b0[p] * (CLAHE_WX - wx) + b1[p] * wx;
+        top = ((top + 8 * LANE_ONES) >> 4) & LANE_MASK6;
+        bot = ((bot + 8 * LANE_ONES) >> 4) & LANE_MASK6;
+        const unsigned int v = top * (CLAHE_WY - wy) + bot * wy + 32 * LANE_ONES;
+        out[x] = clahe_out_r[(v >> 6) & 0xF] | clahe_out_g[(v >> (LANE_G_SHIFT + 6)) & 0xF] |
+                 clahe_out_b[(v >> (LANE_B_SHIFT + 6)) & 0xF];
+        acc += step;
+    }
+}
+
+void ip_clahe(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (!dst) return;
+    for (int v = 0; v < 16; ++v) {
+        clahe_out_r[v] = make_rgb((v * 7 + 7) / 15, 0, 0);
+        clahe_out_g[v] = make_rgb(0, (v * 3 + 7) / 15, 0);
+        clahe_out_b[v] = make_rgb(0, 0, (v * 3 + 7) / 15);
+    }
+    for (int ty = 0; ty < CLAHE_TILES_Y; ++ty)
+        for (int tx = 0; tx < CLAHE_TILES_X; ++tx)
+            clahe_tile(src, ty, tx);
+
+    for (int y = 0; y < RES_Y; ++y) {
+        // Tile rows above and below this pixel row, and the weight of the lower one
+        int ty0 = (y - CLAHE_HALF) / IP_CLAHE_TILE, ty1 = ty0 + 1;
+        unsigned int wy = ((y - CLAHE_HALF - ty0 * IP_CLAHE_TILE) * CLAHE_WY + CLAHE_HALF) / IP_CLAHE_TILE;
+        if (y < CLAHE_HALF) { ty0 = ty1 = 0; wy = 0; }
+        if (ty1 >= CLAHE_TILES_Y) { ty0 = ty1 = CLAHE_TILES_Y - 1; wy = 0; }
+        const unsigned int (*top)[256] = clahe_lut[ty0];
+        const unsigned int (*bot)[256] = clahe_lut[ty1];
+        const unsigned char *in = src[y];
+        volatile unsigned char *out = dst + y * RES_X;
+
+        // Left and right half tiles use one tile column; in between, blend neighbours
+        const int last = CLAHE_TILES_X - 1;
+        clahe_span(in, out, CLAHE_HALF, top[0], top[0], bot[0], bot[0], wy);
+        for (int tx = 0; tx < last; ++tx) {
+            const int x = CLAHE_HALF + tx * IP_CLAHE_TILE;
+            clahe_span(in + x, out + x, IP_CLAHE_TILE, top[tx], top[tx + 1], bot[tx], bot[tx + 1], wy);
+        }
+        clahe_span(in + RES_X - CLAHE_HALF, out + RES_X - CLAHE_HALF, CLAHE_HALF,
+                   top[last], top[last], bot[last], bot[last], wy);
+    }
+}
+
+/* Dithering to a few gray levels
+ * A palette lists the output pixels darkest first. Errors are measured in luma against
+ * the palette entries' real luma, so the dithered image keeps the source brightness.
+ * Floyd-Steinberg keeps one row of carried error (in 1/16 luma units): fs_err[x + 1]
+ * holds the error for column x of the current row until that pixel is visited, after
+ * which it holds the error for column x of the next row. The ordered dither folds the
+ * luma lookup, the 4x4 Bayer threshold and the palette into one table per matrix cell,
+ * so it is a table load per pixel like the point filters.
+ */
+typedef struct {
+    int n;                          // number of output levels
+    unsigned char px[8];            // output pixel of each level
+    unsigned char luma[8];          // luma of each level
+    unsigned char nearest[256];     // level closest to each luma value
+    unsigned char bayer[16][256];   // output per Bayer cell and input pixel
+    int built;
+} dither_palette_t;
+
+// Gray levels as ip_grayscale produces them: make_rgb(g, g >> 1, g >> 1)
+static dither_palette_t dither_gray = { 8, { 0x00, 0x20, 0x4A, 0x6A, 0x94, 0xB4, 0xDE, 0xFE } };
+static dither_palette_t dither_bw   = { 2, { 0x00, 0xFF } };
+
+static const unsigned char bayer4[16] = {
+     0,  8,  2, 10,
+    12,  4, 14,  6,
+     3, 11,  1,  9,
+    15,  7, 13,  5,
+};
+
+static const dither_palette_t *dither_palette(dither_palette_t *pal) {
+    if (pal->built) return pal;
+    const unsigned char *luma = luma_table();
+    for (int k = 0; k < pal->n; ++k)
+        pal->luma[k] = luma[pal->px[k]];
+
+    for (int v = 0; v < 256; ++v) {
+        int k = 0;
+        while (k + 1 < pal->n && 2 * v >= pal->luma[k] + pal->luma[k + 1]) ++k;
+        pal->nearest[v] = k;
+    }
+
+    // Between levels lo and lo + 1, go up when the fraction beats the cell threshold
+    for (int p = 0; p < 256; ++p) {
+        const int v = luma[p];
+        int lo = 0;
+        while (lo + 1 < pal->n && pal->luma[lo + 1] <= v) ++lo;
+        for (int c = 0; c < 16; ++c) {
+            int k = lo;
+            if (lo + 1 < pal->n &&
+                (v - pal->luma[lo]) * 32 > (2 * bayer4[c] + 1) * (pal->luma[lo + 1] - pal->luma[lo]))
+                k = lo + 1;
+            pal->bayer[c][p] = pal->px[k];
+        }
+    }
+    pal->built = 1;
+    return pal;
+}
+
+static int fs_err[RES_X + 2];
+
+static void dither_fs(const dither_palette_t *pal, const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    const unsigned char *luma = luma_table();
+    for (int i = 0; i < RES_X + 2; ++i) fs_err[i] = 0;
+
+    for (int y = 0; y < RES_Y; ++y) {
+        const unsigned char *in = src[y];
+        volatile unsigned char *out = dst + y * RES_X;
+        int right = 0;      // 7/16 carried to the next pixel
+        int below_left = 0; // 1/16 from the previous pixel, for (x, y + 1)
+        for (int x = 0; x < RES_X; ++x) {
+            int v = (luma[in[x]] * 16 + fs_err[x + 1] + right + 8) >> 4;
+            v = (v < 0) ? 0 : (v > 255) ? 255 : v;
+            const int k = pal->nearest[v];
+            out[x] = pal->px[k];
+
+            const int e = v - pal->luma[k];
+            fs_err[x] += 3 * e;
+            fs_err[x + 1] = 5 * e + below_left;
+            below_left = e;
+            right = 7 * e;
+        }
+    }
+}
+
+static void dither_ordered(const dither_palette_t *pal, const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    for (int y = 0; y < RES_Y; ++y) {
+        const unsigned char (*cell)[256] = pal->bayer + (y & 3) * 4;
+        const unsigned char *in = src[y];
+        volatile unsigned char *out = dst + y * RES_X;
+        for (int x = 0; x < RES_X; x += 4) {
+            out[x]     = cell[0][in[x]];
+            out[x + 1] = cell[1][in[x + 1]];
+            out[x + 2] = cell[2][in[x + 2]];
+            out[x + 3] = cell[3][in[x + 3]];
+        }
+    }
+}
+
+void ip_dither_fs_gray(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (dst) dither_fs(dither_palette(&dither_gray), src, dst);
+}
+
+void ip_dither_fs_bw(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (dst) dither_fs(dither_palette(&dither_bw), src, dst);
+}
+
+void ip_dither_ordered_gray(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (dst) dither_ordered(dither_palette(&dither_gray), src, dst);
+}
+
+void ip_dither_ordered_bw(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    if (dst) dither_ordered(dither_palette(&dither_bw), src, dst);
+}
+
+/* Binary images, 1 bit per pixel
+ * Bit i of word j in a row is pixel 32 * j + i. A pixel is set where the packed byte is
+ * >= BW_THRESHOLD, i.e. exactly the white pixels of ip_blackwhite.
+ * Morphology uses a (2r+1) x (2r+1) square, clipped at the image border (outside pixels
+ * never erode or dilate anything). Erosion is separable:
+ *  - horizontally, the AND over r+1 bits ahead and r+1 bits behind, each built by
+ *    doubling shifted copies of the whole row (log2(r+1) multi-word shift-ANDs);
+ *  - vertically, van Herk/Gil-Werman on word columns: prefix and suffix ANDs within
+ *    blocks of 2r+1 rows, so every output word costs one AND whatever the radius.
+ * Dilation is erosion of the complement.
+ */
+#define BIN_ONES  0xFFFFFFFFu
+#define BIN_ROWS  (RES_Y + 2 * IP_BIN_MAX_RADIUS)
+
+static unsigned int bin_g[BIN_ROWS][IP_BIN_WORDS];   // vHGW prefix ANDs
+static unsigned int bin_h[BIN_ROWS][IP_BIN_WORDS];   // vHGW suffix ANDs
+
+void ip_to_binary(const unsigned char src[RES_Y][RES_X], ip_binary_t *bin) {
+    const int aligned = swar_aligned(src, bin);   // rows are a multiple of 4 bytes
+    for (int y = 0; y < RES_Y; ++y) {
+        unsigned int *out = bin->w[y];
+        if (aligned) {
+            // Gather the top bit of 4 bytes into 4 bits with one multiply
+            const unsigned int *s = (const unsigned int *)src[y];
+            for (int j = 0; j < IP_BIN_WORDS; ++j) {
+                unsigned int bits = 0;
+                for (int q = 0; q < 8; ++q) {
+                    unsigned int m = (s[8 * j + q] >> 7) & SWAR_LO;
+                    bits |= ((m * 0x10204080u) >> 28) << (4 * q);
+                }
+                out[j] = bits;
+            }
+        } else {
+            for (int j = 0; j < IP_BIN_WORDS; ++j) {
+                unsigned int bits = 0;
+                for (int i = 0; i < 32; ++i)
+                    bits |= (unsigned int)(src[y][32 * j + i] >= BW_THRESHOLD) << i;
+                out[j] = bits;
+            }
+        }
+    }
+}
+
+// One binary row out as 0/255 bytes, four at a time when 'row' is word aligned
+static void bin_row_out(const unsigned int *bits_row, volatile unsigned char *row, int aligned) {
+    static const unsigned int expand[16] = {
+        0x00000000, 0x000000FF, 0x0000FF00, 0x0000FFFF, 0x00FF0000, 0x00FF00FF, 0x00FFFF00, 0x00FFFFFF,
+        0xFF000000, 0xFF0000FF, 0xFF00FF00, 0xFF00FFFF, 0xFFFF0000, 0xFFFF00FF, 0xFFFFFF00, 0xFFFFFFFF,
+    };
+    for (int j = 0; j < IP_BIN_WORDS; ++j) {
+        unsigned int bits = bits_row[j];
+        if (aligned) {
+            volatile unsigned int *d = (volatile unsigned int *)(row + 32 * j);
+            for (int q = 0; q < 8; ++q)
+                d[q] = expand[(bits >> (4 * q)) & 0xF];
+        } else {
+            for (int i = 0; i < 32; ++i)
+                row[32 * j + i] = ((bits >> i) & 1) ? 255 : 0;
+        }
+    }
+}
+
+void ip_from_binary(const ip_binary_t *bin, volatile unsigned char *dst) {
+    if (!dst) return;
+    const int aligned = swar_aligned(bin, dst);   // rows are a multiple of 4 bytes
+    for (int y = 0; y < RES_Y; ++y)
+        bin_row_out(bin->w[y], dst + y * RES_X, aligned);
+}
+
+// out = a shifted so that bit x of out is bit x + s of a (s may be negative), ones shifted in
+static void bin_shift(const unsigned int *a, unsigned int *out, int s) {
+    const int back = s < 0;
+    const int n = back ? -s : s;
+    const int ws = n >> 5, bs = n & 31;
+    for (int i = 0; i < IP_BIN_WORDS; ++i) {
+        if (!back) {
+            unsigned int lo = (i + ws < IP_BIN_WORDS) ? a[i + ws] : BIN_ONES;
+            unsigned int hi = (i + ws + 1 < IP_BIN_WORDS) ? a[i + ws + 1] : BIN_ONES;
+            out[i] = bs ? (lo >> bs) | (hi << (32 - bs)) : lo;
+        } else {
+            unsigned int hi = (i - ws >= 0) ? a[i - ws] : BIN_ONES;
+            unsigned int lo = (i - ws - 1 >= 0) ? a[i - ws - 1] : BIN_ONES;
+            out[i] = bs ? (hi << bs) | (lo >> (32 - bs)) : hi;
+        }
+    }
+}
+
+// out &= AND of 'len' bits starting at each pixel and going in direction 'dir' (+1 or -1)
+static void bin_run_and(const unsigned int *row, unsigned int *out, int len, int dir) {
+    unsigned int win[IP_BIN_WORDS], tmp[IP_BIN_WORDS];
+    int span = 1, have = 0;   // win covers 'span' bits, out already covers 'have' bits
+    for (int i = 0; i < IP_BIN_WORDS; ++i) win[i] = row[i];
+    while (len) {
+        if (len & 1) {
+            bin_shift(win, tmp, dir * have);
+            for (int i = 0; i < IP_BIN_WORDS; ++i) out[i] &= tmp[i];
+            have += span;
+        }
+        len >>= 1;
+        if (len) {
+            bin_shift(win, tmp, dir * span);
+            for (int i = 0; i < IP_BIN_WORDS; ++i) win[i] &= tmp[i];
+            span <<= 1;
+        }
+    }
+}
+
+static inline int bin_radius(int radius) {
+    if (radius < 1) return 1;
+    if (radius > IP_BIN_MAX_RADIUS) return IP_BIN_MAX_RADIUS;
+    return radius;
+}
+
+void ip_bin_erode(const ip_binary_t *src, ip_binary_t *dst, int radius) {
+    const int rad = bin_radius(radius);
+    const int k = 2 * rad + 1, rows = RES_Y + 2 * rad;
+
+    // Horizontal pass, row by row (dst may alias src)
+    for (int y = 0; y < RES_Y; ++y) {
+        unsigned int row[IP_BIN_WORDS], out[IP_BIN_WORDS];
+        for (int i = 0; i < IP_BIN_WORDS; ++i) row[i] = src->w[y][i], out[i] = BIN_ONES;
+        bin_run_and(row, out, rad + 1, 1);
+        bin_run_and(row, out, rad + 1, -1);
+        for (int i = 0; i < IP_BIN_WORDS; ++i) dst->w[y][i] = out[i];
+    }
+
+    // Vertical pass: padded row p is image row p - rad, all ones outside the image
+    for (int p = 0; p < rows; ++p) {
+        const int y = p - rad;
+        const int start = (p % k) == 0;
+        for (int i = 0; i < IP_BIN_WORDS; ++i) {
+            unsigned int v = (y >= 0 && y < RES_Y) ? dst->w[y][i] : BIN_ONES;
+            bin_g[p][i] = start ? v : bin_g[p - 1][i] & v;
+        }
+    }
+    for (int p = rows - 1; p >= 0; --p) {
+        const int y = p - rad;
+        const int end = (p % k) == k - 1 || p == rows - 1;
+        for (int i = 0; i < IP_BIN_WORDS; ++i) {
+            unsigned int v = (y >= 0 && y < RES_Y) ? dst->w[y][i] : BIN_ONES;
+            bin_h[p][i] = end ? v : bin_h[p + 1][i] & v;
+        }
+    }
+    // Output row y covers padded rows y .. y + 2r
+    for (int y = 0; y < RES_Y; ++y)
+        for (int i = 0; i < IP_BIN_WORDS; ++i)
+            dst->w[y][i] = bin_h[y][i] & bin_g[y + 2 * rad][i];
+}
+
+static void bin_not(const ip_binary_t *src, ip_binary_t *dst) {
+    for (int y = 0; y < RES_Y; ++y)
+        for (int i = 0; i < IP_BIN_WORDS; ++i)
+            dst->w[y][i] = ~src->w[y][i];
+}
+
+void ip_bin_dilate(const ip_binary_t *src, ip_binary_t *dst, int radius) {
+    bin_not(src, dst);
+    ip_bin_erode(dst, dst, radius);
+    bin_not(dst, dst);
+}
+
+void ip_bin_open(const ip_binary_t *src, ip_binary_t *dst, int radius) {
+    ip_bin_erode(src, dst, radius);
+    ip_bin_dilate(dst, dst, radius);
+}
+
+void ip_bin_close(const ip_binary_t *src, ip_binary_t *dst, int radius) {
+    ip_bin_dilate(src, dst, radius);
+    ip_bin_erode(dst, dst, radius);
+}
+
+// Threshold, run one binary operation in place, expand back to 0/255 bytes
+static ip_binary_t bin_frame;
+
+#define IP_BINARY_FILTER(name)                                                                          \
+    void ip_##name(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius) {    \
+        if (!dst) return;                                                                               \
+        ip_to_binary(src, &bin_frame);                                                                  \
+        ip_bin_##name(&bin_frame, &bin_frame, radius);                                                  \
+        ip_from_binary(&bin_frame, dst);                                                                \
+    }
+
+IP_BINARY_FILTER(erode)
+IP_BINARY_FILTER(dilate)
+IP_BINARY_FILTER(open)
+IP_BINARY_FILTER(close)
+
+/* Connected components over runs (8-connectivity)
+ * Each row of a binary image is cut into runs of set pixels. Run edges are found from the
+ * bit transitions of whole words (w ^ (w << 1)), one de Bruijn lookup per edge, so blank
+ * and solid words cost nothing per pixel. A run is joined with every run of the previous
+ * row that touches it, found with two pointers, in a union-find over run indices that
+ * always keeps the lowest index as root and halves paths on lookup. Labels are then
+ * numbered in raster order and stored per run, not per pixel. There is one workspace,
+ * shared with the Canny hysteresis; components past IP_CCL_MAX_BLOBS are counted in
+ * n_dropped but get no blob.
+ */
+static unsigned short ccl_parent[IP_CCL_MAX_RUNS];
+static ip_ccl_t ccl_work;
+
+static const unsigned char debruijn_pos[32] = {
+     0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+    31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9,
+};
+
+static unsigned int ccl_find(unsigned int i) {
+    while (ccl_parent[i] != i) {
+        ccl_parent[i] = ccl_parent[ccl_parent[i]];
+        i = ccl_parent[i];
+    }
+    return i;
+}
+
+static void ccl_union(unsigned int a, unsigned int b) {
+    a = ccl_find(a);
+    b = ccl_find(b);
+    if (a < b) ccl_parent[b] = a;
+    else if (b < a) ccl_parent[a] = b;
+}
+
+// Append the runs of one binary row; returns the new run count
+static int ccl_row_runs(const unsigned int *row, int y, ip_run_t *runs, int n) {
+    unsigned int carry = 0;   // previous pixel, as bit 0
+    int start = 0;
+    for (int j = 0; j < IP_BIN_WORDS; ++j) {
+        const unsigned int w = row[j];
+        unsigned int edges = w ^ ((w << 1) | carry);
+        carry = w >> 31;
+        while (edges) {
+            const unsigned int low = edges & -edges;
+            const int x = 32 * j + debruijn_pos[(low * 0x077CB531u) >> 27];
+            if (w & low) {
+                start = x;
+            } else {
+                runs[n].x0 = start; runs[n].x1 = x - 1; runs[n].y = y;
+                n++;
+            }
+            edges ^= low;
+        }
+    }
+    if (carry) {
+        runs[n].x0 = start; runs[n].x1 = RES_X - 1; runs[n].y = y;
+        n++;
+    }
+    return n;
+}
+
+// Append the runs of row y and join them with the touching runs of the previous row,
+// which are [prev, n); returns the new run count
+static int ccl_join_row(const unsigned int *row, int y, ip_run_t *runs, int n, int prev) {
+    const int row_start = n;
+    n = ccl_row_runs(row, y, runs, n);
+    int k = prev;
+    for (int i = row_start; i < n; ++i) {
+        ccl_parent[i] = i;
+        while (k < row_start && runs[k].x1 + 1 < runs[i].x0) ++k;
+        for (int m = k; m < row_start && runs[m].x0 <= runs[i].x1 + 1; ++m)
+            ccl_union(i, m);
+    }
+    return n;
+}
+
+const ip_ccl_t *ip_label(const ip_binary_t *bin) {
+    ip_ccl_t *ccl = &ccl_work;
+    ip_run_t *runs = ccl->runs;
+    int n = 0, prev = 0;   // runs of the previous row are [prev, row_start)
+
+    for (int y = 0; y < RES_Y; ++y) {
+        const int row_start = n;
+        n = ccl_join_row(bin->w[y], y, runs, n, prev);
+        prev = row_start;
+    }
+
+    // Roots are the first run of their component, so they are numbered first
+    int blobs = 0, dropped = 0;
+    for (int i = 0; i < n; ++i) {
+        const unsigned int root = ccl_find(i);
+        ip_blob_t *b;
+        if (root == (unsigned int)i) {
+            if (blobs == IP_CCL_MAX_BLOBS) {
+                runs[i].label = IP_CCL_NO_BLOB;
+                dropped++;
+                continue;
+            }
+            runs[i].label = blobs;
+            b = &ccl->blobs[blobs++];
+            b->x0 = runs[i].x0; b->x1 = runs[i].x1;
+            b->y0 = b->y1 = runs[i].y;
+            b->area = 0;
+        } else {
+            runs[i].label = runs[root].label;
+            if (runs[i].label == IP_CCL_NO_BLOB) continue;
+            b = &ccl->blobs[runs[i].label];
+            if (runs[i].x0 < b->x0) b->x0 = runs[i].x0;
+            if (runs[i].x1 > b->x1) b->x1 = runs[i].x1;
+            b->y1 = runs[i].y;
+        }
+        b->area += runs[i].x1 - runs[i].x0 + 1;
+    }
+    ccl->n_runs = n;
+    ccl->n_blobs = blobs;
+    ccl->n_dropped = dropped;
+    return ccl;
+}
+
+void ip_draw_blobs(const ip_ccl_t *ccl, volatile unsigned char *dst, unsigned int min_area) {
+    static const unsigned char colors[6] = { 0xE0, 0x18, 0x06, 0xF8, 0x1E, 0xE6 };  // R G B Y C M
+    if (!dst) return;
+    int shown = 0;
+    for (int i = 0; i < ccl->n_blobs; ++i) {
+        const ip_blob_t *b = &ccl->blobs[i];
+        if (b->area < min_area) continue;
+        const unsigned char c = colors[shown++ % 6];
+        for (int x = b->x0; x <= b->x1; ++x) {
+            dst_write(dst, b->y0, x, c);
+            dst_write(dst, b->y1, x, c);
+        }
+        for (int y = b->y0; y <= b->y1; ++y) {
+            dst_write(dst, y, b->x0, c);
+            dst_write(dst, y, b->x1, c);
+        }
+    }
+}
+
+/* Canny edges on luma
+ * Luma is computed once per pixel and Sobel runs on that single channel. The stages
+ * stream through rings of three rows: luma rows feed gradient rows (|gx| + |gy| and a
+ * direction bin), gradient rows feed non-maximum suppression one row behind. The
+ * direction is binned with integer compares against tan(22.5 deg) ~ 106/256, no atan.
+ * Suppression yields one row of strong (>= high) and weak (>= low) survivors, which
+ * hysteresis takes right away: the runs of strong|weak are joined with the previous
+ * row's in the labeller's union-find, each run flagged if it holds a strong pixel.
+ * Only the run list spans the frame; at the end the components with a flagged run
+ * are kept and written out row by row.
+ */
+#define CANNY_DIR_H    0    // gradient mostly along x: compare left and right
+#define CANNY_DIR_D45  1    // gx and gy same sign: compare up-left and down-right
+#define CANNY_DIR_V    2    // gradient mostly along y: compare up and down
+#define CANNY_DIR_D135 3    // opposite signs: compare up-right and down-left
+
+#define CANNY_RUN_STRONG 1  // run label bits during hysteresis
+#define CANNY_KEEP       2  // set on the root of a component with a strong run
+
+static unsigned char canny_luma[3][RES_X];
+static unsigned short canny_mag[3][RES_X + 2];         // padded by a zero column each side
+static const unsigned short canny_zero[RES_X + 2];     // magnitude outside the image
+static unsigned char canny_dir[3][RES_X];
+static int canny_cs[RES_X + 2], canny_cd[RES_X + 2];   // per column, padded by one
+static unsigned int canny_strong[IP_BIN_WORDS];        // suppressed row: strong pixels
+static unsigned int canny_edge[IP_BIN_WORDS];          // suppressed row: strong | weak
+
+static void canny_luma_row(const unsigned char src[RES_Y][RES_X], int y, unsigned char *out) {
+    const unsigned char *luma = luma_table();
+    const unsigned char *row = row_any(src, y);
+    for (int x = 0; x < RES_X; ++x)
+        out[x] = luma[row[x]];
+}
+
+// Column sums at padded index i = x + 1; only the two border columns go through col_at()
+static inline void canny_border_col(const unsigned char *l0, const unsigned char *l1, const unsigned char *l2,
+                                    int x) {
+    canny_cs[x + 1] = col_at(l0, x) + 2 * col_at(l1, x) + col_at(l2, x);
+    canny_cd[x + 1] = col_at(l2, x) - col_at(l0, x);
+}
+
+static void canny_grad_row(const unsigned char *l0, const unsigned char *l1, const unsigned char *l2,
+                           unsigned short *mag, unsigned char *dir) {
+    // Vertical smoothing (for gx) and difference (for gy) per column
+    int *cs = canny_cs, *cd = canny_cd;
+    canny_border_col(l0, l1, l2, -1);
+    for (int x = 0; x < RES_X; ++x) {
+        cs[x + 1] = l0[x] + 2 * l1[x] + l2[x];
+        cd[x + 1] = l2[x] - l0[x];
+    }
+    canny_border_col(l0, l1, l2, RES_X);
+    for (int x = 0; x < RES_X; ++x) {
+        const int gx = cs[x + 2] - cs[x];
+        const int gy = cd[x] + 2 * cd[x + 1] + cd[x + 2];
+        const int ax = gx < 0 ? -gx : gx, ay = gy < 0 ? -gy : gy;
+        mag[x] = ax + ay;
+        if (ay * 256 <= ax * 106)      dir[x] = CANNY_DIR_H;
+        else if (ay * 106 >= ax * 256) dir[x] = CANNY_DIR_V;
+        else                           dir[x] = ((gx ^ gy) >= 0) ? CANNY_DIR_D45 : CANNY_DIR_D135;
+    }
+}
+
+// Non-maximum suppression of one row into canny_strong / canny_edge. The rows point at
+// column 0 of padded magnitude rows, so x - 1 and x + 1 never leave them.
+static void canny_nms_row(const unsigned short *up, const unsigned short *mid, const unsigned short *down,
+                          const unsigned char *dir, int low, int high) {
+    unsigned int *strong = canny_strong, *edge = canny_edge;
+    for (int j = 0; j < IP_BIN_WORDS; ++j) strong[j] = edge[j] = 0;
+
+    for (int x = 0; x < RES_X; ++x) {
+        const unsigned int m = mid[x];
+        if (m < (unsigned int)low) continue;
+        unsigned int a, b;
+        switch (dir[x]) {
+            case CANNY_DIR_H:   a = mid[x - 1]; b = mid[x + 1];  break;
+            case CANNY_DIR_D45: a = up[x - 1];  b = down[x + 1]; break;
+            case CANNY_DIR_V:   a = up[x];      b = down[x];     break;
+            default:            a = up[x + 1];  b = down[x - 1]; break;
+        }
+        if (m <= a || m < b) continue;   // ties go to the earlier pixel only
+        const unsigned int bit = 1u << (x & 31);
+        edge[x >> 5] |= bit;
+        if (m >= (unsigned int)high) strong[x >> 5] |= bit;
+    }
+}
+
+// Any set bit in x0..x1 of a binary row
+static int bin_any(const unsigned int *row, int x0, int x1) {
+    for (int j = x0 >> 5; j <= x1 >> 5; ++j) {
+        unsigned int m = row[j];
+        if (j == x0 >> 5) m &= ~0u << (x0 & 31);
+        if (j == x1 >> 5) m &= ~0u >> (31 - (x1 & 31));
+        if (m) return 1;
+    }
+    return 0;
+}
+
+void ip_canny_thresholds(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int low, int high) {
+    if (!dst) return;
+    ip_run_t *runs = ccl_work.runs;
+    int n = 0, prev = 0;   // runs of the previous suppressed row are [prev, n)
+
+    // Prime the rings: luma rows -1 and 0
+    canny_luma_row(src, -1, canny_luma[2]);
+    canny_luma_row(src, 0, canny_luma[0]);
+    for (int y = 0; y <= RES_Y; ++y) {
+        if (y < RES_Y) {
+            canny_luma_row(src, y + 1, canny_luma[(y + 1) % 3]);
+            canny_grad_row(canny_luma[(y + 2) % 3], canny_luma[y % 3], canny_luma[(y + 1) % 3],
+                           canny_mag[y % 3] + 1, canny_dir[y % 3]);
+        }
+        if (y >= 1) {
+            const int ny = y - 1;
+            canny_nms_row(ny > 0 ? canny_mag[(ny + 2) % 3] + 1 : canny_zero + 1, canny_mag[ny % 3] + 1,
+                          ny < RES_Y - 1 ? canny_mag[(ny + 1) % 3] + 1 : canny_zero + 1,
+                          canny_dir[ny % 3], low, high);
+
+            // Hysteresis, one row behind suppression
+            const int row_start = n;
+            n = ccl_join_row(canny_edge, ny, runs, n, prev);
+            for (int i = row_start; i < n; ++i)
+                runs[i].label = bin_any(canny_strong, runs[i].x0, runs[i].x1) ? CANNY_RUN_STRONG : 0;
+            prev = row_start;
+        }
+    }
+
+    // Resolve: keep every component with a strong run, then write the rows out
+    for (int i = 0; i < n; ++i)
+        if (runs[i].label & CANNY_RUN_STRONG)
+            runs[ccl_find(i)].label |= CANNY_KEEP;
+    const int aligned = swar_aligned(canny_edge, dst);
+    int i = 0;
+    for (int y = 0; y < RES_Y; ++y) {
+        for (int j = 0; j < IP_BIN_WORDS; ++j) canny_edge[j] = 0;
+        for (; i < n && runs[i].y == y; ++i) {
+            if (!(runs[ccl_find(i)].label & CANNY_KEEP)) continue;
+            for (int x = runs[i].x0; x <= runs[i].x1; ++x)
+                canny_edge[x >> 5] |= 1u << (x & 31);
+        }
+        bin_row_out(canny_edge, dst + y * RES_X, aligned);
+    }
+    // The workspace holds runs but no blobs now
+    ccl_work.n_runs = n;
+    ccl_work.n_blobs = 0;
+    ccl_work.n_dropped = 0;
+}
+
+void ip_canny(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {
+    ip_canny_thresholds(src, dst, IP_CANNY_LOW, IP_CANNY_HIGH);
+}
+
+/* Bilateral filter from small weight tables
+ * Every weight is 127 * exp(-t) with t in 1/8 steps, read from bil_exp[], so there is no
+ * exp() and no softfloat. The range weight depends only on the channel differences of
+ * the centre and the tap (8 x 4 x 4 combinations); it is tabulated for every pair of
+ * pixel values, 128 x 128 bytes since bit 0 is unused. The tap weight is the product of
+ * the spatial and range weights, >> 7; the products are tabulated too, and each offset of
+ * the window points at the product row of its spatial weight, so a tap is two lookups and
+ * only the two channel-sum multiplies. Red and green sums share one word (green in the low
+ * half, red in the high half, both < 2^16 for 49 taps), blue has its own. Normalization
+ * multiplies by a reciprocal of the total weight from a table.
+ */
+#define BIL_MAX_TAPS   ((2 * IP_BILATERAL_MAX_RADIUS + 1) * (2 * IP_BILATERAL_MAX_RADIUS + 1))
+#define BIL_MAX_WEIGHT (BIL_MAX_TAPS * 127)
+#define BIL_RECIP_BITS 20
+
+static const unsigned char bil_exp[64] = {
+    127, 112,  99,  87,  77,  68,  60,  53,  47,  41,  36,  32,  28,  25,  22,  19,
+     17,  15,  13,  12,  10,   9,   8,   7,   6,   6,   5,   4,   4,   3,   3,   3,
+      2,   2,   2,   2,   1,   1,   1,   1,   1,   1,   1,   1,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static unsigned char bil_range[128][128];
+static unsigned char bil_product[128][128];           // (spatial * range) >> 7
+static unsigned int bil_recip[BIL_MAX_WEIGHT + 1];
+static const unsigned char *bil_space[BIL_MAX_TAPS];  // per offset: product row of its spatial weight
+static int bil_ready = 0;
+
+// 127 * exp(-num / den), num / den >= 0
+static inline unsigned char bil_weight(unsigned int num, unsigned int den) {
+    const unsigned int i = num * 8 / den;
+    return (i < 64) ? bil_exp[i] : 0;
+}
+
+static void bil_init(void) {
+    if (bil_ready) return;
+    // Range distance on channels expanded to 0-255, sigma IP_BILATERAL_SIGMA_R
+    for (int p = 0; p < 128; ++p)
+        for (int q = 0; q < 128; ++q) {
+            const int dr = (get_red(p << 1) - get_red(q << 1)) * 255 / 7;
+            const int dg = (get_green(p << 1) - get_green(q << 1)) * 85;
+            const int db = (get_blue(p << 1) - get_blue(q << 1)) * 85;
+            bil_range[p][q] = bil_weight(dr * dr + dg * dg + db * db,
+                                         2 * IP_BILATERAL_SIGMA_R * IP_BILATERAL_SIGMA_R);
+        }
+    for (int s = 0; s < 128; ++s)
+        for (int r = 0; r < 128; ++r)
+            bil_product[s][r] = (s * r) >> 7;
+    bil_recip[0] = 0;
+    for (int w = 1; w <= BIL_MAX_WEIGHT; ++w)
+        bil_recip[w] = (1u << BIL_RECIP_BITS) / w;
+    bil_ready = 1;
+}
+
+static inline unsigned char bil_norm(unsigned int sum, unsigned int recip) {
+    return (sum * recip + (1u << (BIL_RECIP_BITS - 1))) >> BIL_RECIP_BITS;
+}
+
+void ip_bilateral(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius) {
+    if (!dst) return;
+    bil_init();
+    const int rad = (radius < 1) ? 1 : (radius > IP_BILATERAL_MAX_RADIUS) ? IP_BILATERAL_MAX_RADIUS : radius;
+    const int size = 2 * rad + 1;
+
+    // Spatial weights, sigma = radius
+    for (int dy = -rad; dy <= rad; ++dy)
+        for (int dx = -rad; dx <= rad; ++dx)
+            bil_space[(dy + rad) * size + dx + rad] = bil_product[bil_weight(dx * dx + dy * dy, 2 * rad * rad)];
+
+    const unsigned char *rows[2 * IP_BILATERAL_MAX_RADIUS + 1];
+    for (int y = 0; y < RES_Y; ++y) {
+        for (int k = 0; k < size; ++k) rows[k] = row_any(src, y + k - rad);
+        volatile unsigned char *out = dst + y * RES_X;
+
+        for (int x = 0; x < RES_X; ++x) {
+            const unsigned char *range = bil_range[src[y][x] >> 1];
+            const int inside = x >= rad && x < RES_X - rad;
+            unsigned int w_sum = 0, rg = 0, b = 0;
+            const unsigned char *const *space = bil_space;
+            for (int k = 0; k < size; ++k) {
+                const unsigned char *row = rows[k];
+                for (int dx = -rad; dx <= rad; ++dx) {
+                    const unsigned char q = inside ? row[x + dx] : col_at(row, x + dx);
+                    const unsigned int w = (*space++)[range[q >> 1]];
+                    w_sum += w;
+                    rg += w * (get_green(q) | (get_red(q) << 16));
+                    b += w * get_blue(q);
+                }
+            }
+            const unsigned int recip = bil_recip[w_sum];
+            out[x] = make_rgb(bil_norm(rg >> 16, recip), bil_norm(rg & 0xFFFF, recip), bil_norm(b, recip));
+        }
+    }
+}
+
+/* Compile-time specialized NxN convolution engine
+ * A kernel is an X-macro listing its taps as OP(row, column, weight); IP_CONVOLUTION()
+ * expands every tap into straight-line code with the weight as a literal, so the compiler
+ * drops zero taps (and their loads) and turns weights 1, 2, 4, ... into adds and shifts.
+ *
+ * Kernels whose channel sums fit a 10-bit lane (7 * sum|w| < 1024) accumulate in the
+ * packed lanes of lane_decode[] with a bias of 7 * (sum of negative weights), and the
+ * divide, mid-level offset and clamp per channel become one lookup in a per-kernel table.
+ * Larger kernels (e.g. the 5x5 Gaussian) accumulate per channel instead.
+ *
+ * out_c = clamp(sum_c / div + (mid ? half range : 0), 0, channel max)
+ */
+#define IP_CONV_MAX 5
+
+typedef void (*convrow_fn)(const unsigned char *const *rows, volatile unsigned char *out);
+
+#define IP_CONV_POS(ky, kx, w)  + ((w) > 0 ? (w) : 0)
+#define IP_CONV_NEG(ky, kx, w)  + ((w) < 0 ? -(w) : 0)
+#define IP_CONV_LANE(ky, kx, w) acc += (unsigned int)(w) * lane_decode[r[ky][x + (kx)]];
+#define IP_CONV_CHAN(ky, kx, w) {                                          \
+        unsigned char p = r[ky][x + (kx)];                                 \
+        sr += (w) * get_red(p);                                            \
+        sg += (w) * get_green(p);                                          \
+        sb += (w) * get_blue(p);                                           \
+    }
+
+static inline int conv_channel(int sum, int div, int mid, int max) {
+    int v = sum / div + (mid ? (max + 1) / 2 : 0);
+    return (v < 0) ? 0 : (v > max) ? max : v;
+}
+
+static inline unsigned char conv_pack(int sr, int sg, int sb, int div, int mid) {
+    return make_rgb(conv_channel(sr, div, mid, 7), conv_channel(sg, div, mid, 3), conv_channel(sb, div, mid, 3));
+}
+
+// Lane value v (biased by 'bias') -> channel bits, for each of the three lanes
+static void conv_table_init(unsigned char *tab, int range, int bias, int div, int mid) {
+    for (int v = 0; v < range; ++v) {
+        tab[v]             = make_rgb(conv_channel(v - bias, div, mid, 7), 0, 0);
+        tab[range + v]     = make_rgb(0, conv_channel(v - bias, div, mid, 3), 0);
+        tab[2 * range + v] = make_rgb(0, 0, conv_channel(v - bias, div, mid, 3));
+    }
+}
+
+// Whole frame: pick the n rows around y (through row_at() outside the image)
+static void run_nxn(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int n, convrow_fn row) {
+    const unsigned char *rows[IP_CONV_MAX];
+    for (int y = 0; y < RES_Y; ++y) {
+        for (int k = 0; k < n; ++k) {
+            int yy = y + k - n / 2;
+            rows[k] = (yy < 0 || yy >= RES_Y) ? row_at(src, yy) : src[yy];
+        }
+        row(rows, dst + y * RES_X);
+    }
+}
+
+#define IP_CONVOLUTION(name, n, div, mid, TAPS)                                                   \
+    enum {                                                                                        \
+        name##_pos = 0 TAPS(IP_CONV_POS),                                                         \
+        name##_neg = 0 TAPS(IP_CONV_NEG),                                                         \
+        name##_lanes = (7 * (name##_pos + name##_neg) < 1024),                                    \
+        name##_range = name##_lanes ? 7 * (name##_pos + name##_neg) + 1 : 1                       \
+    };                                                                                            \
+    static unsigned char name##_tab[3][name##_range];                                             \
+                                                                                                  \
+    /* r[ky][x + kx] is tap (ky, kx) of the window centred on column x */                       \
+    static inline unsigned char name##_px(const unsigned char *const *r, int x) {                 \
+        if (name##_lanes) {                                                                       \
+            unsigned int acc = (7u * name##_neg) * LANE_ONES;                                     \
+            TAPS(IP_CONV_LANE)                                                                    \
+            return name##_tab[0][acc & 0x3FF]                                                     \
+                 | name##_tab[1][(acc >> LANE_G_SHIFT) & 0x3FF]                                   \
+                 | name##_tab[2][(acc >> LANE_B_SHIFT) & 0x3FF];                                  \
+        } else {                                                                                  \
+            int sr = 0, sg = 0, sb = 0;                                                           \
+            TAPS(IP_CONV_CHAN)                                                                    \
+            return conv_pack(sr, sg, sb, div, mid);                                               \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_row(const unsigned char *const *rows, volatile unsigned char *out) {       \
+        const unsigned char *r[n];                                                                \
+        for (int k = 0; k < n; ++k) r[k] = rows[k] - n / 2;                                       \
+        for (int x = n / 2; x < RES_X - n / 2; ++x)                                               \
+            out[x] = name##_px(r, x);                                                             \
+                                                                                                  \
+        /* Border columns: gather the window through col_at() */                                  \
+        unsigned char win[n][n];                                                                  \
+        const unsigned char *w[n];                                                                \
+        for (int x = 0; x < RES_X; ++x) {                                                         \
+            if (x == n / 2) x = RES_X - n / 2;                                                    \
+            for (int ky = 0; ky < n; ++ky) {                                                      \
+                for (int kx = 0; kx < n; ++kx)                                                    \
+                    win[ky][kx] = col_at(rows[ky], x + kx - n / 2);                               \
+                w[ky] = win[ky];                                                                  \
+            }                                                                                     \
+            out[x] = name##_px(w, 0);                                                             \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    void ip_##name(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst) {          \
+        static int built = 0;                                                                     \
+        if (!dst) return;                                                                         \
+        lanes_init();                                                                             \
+        if (name##_lanes && !built) {                                                             \
+            conv_table_init(&name##_tab[0][0], name##_range, 7 * name##_neg, div, mid);           \
+            built = 1;                                                                            \
+        }                                                                                         \
+        run_nxn(src, dst, n, name##_row);                                                         \
+    }
+
+/* Gaussian 3x3
+ * [ 1 2 1 ]
+ * [ 2 4 2 ] / 16
+ * [ 1 2 1 ]
+ */
+#define K_GAUSSIAN3X3(OP) \
+    OP(0,0,1) OP(0,1,2) OP(0,2,1) \
+    OP(1,0,2) OP(1,1,4) OP(1,2,2) \
+    OP(2,0,1) OP(2,1,2) OP(2,2,1)
+IP_CONVOLUTION(gaussian3x3, 3, 16, 0, K_GAUSSIAN3X3)
+
+/* Gaussian 5x5, outer product of [1 4 6 4 1], / 256 (too wide for lanes) */
+#define K_GAUSSIAN5X5(OP) \
+    OP(0,0,1) OP(0,1,4)  OP(0,2,6)  OP(0,3,4)  OP(0,4,1) \
+    OP(1,0,4) OP(1,1,16) OP(1,2,24) OP(1,3,16) OP(1,4,4) \
+    OP(2,0,6) OP(2,1,24) OP(2,2,36) OP(2,3,24) OP(2,4,6) \
+    OP(3,0,4) OP(3,1,16) OP(3,2,24) OP(3,3,16) OP(3,4,4) \
+    OP(4,0,1) OP(4,1,4)  OP(4,2,6)  OP(4,3,4)  OP(4,4,1)
+IP_CONVOLUTION(gaussian5x5, 5, 256, 0, K_GAUSSIAN5X5)
+
+/* Box blur 5x5, all ones / 25 */
+#define K_BOX5X5(OP) \
+    OP(0,0,1) OP(0,1,1) OP(0,2,1) OP(0,3,1) OP(0,4,1) \
+    OP(1,0,1) OP(1,1,1) OP(1,2,1) OP(1,3,1) OP(1,4,1) \
+    OP(2,0,1) OP(2,1,1) OP(2,2,1) OP(2,3,1) OP(2,4,1) \
+    OP(3,0,1) OP(3,1,1) OP(3,2,1) OP(3,3,1) OP(3,4,1) \
+    OP(4,0,1) OP(4,1,1) OP(4,2,1) OP(4,3,1) OP(4,4,1)
+IP_CONVOLUTION(box5x5, 5, 25, 0, K_BOX5X5)
+
+/* Emboss, offset to mid level
+ * [ -2 -1  0 ]
+ * [ -1  1  1 ]
+ * [  0  1  2 ]
+ */
+#define K_EMBOSS(OP) \
+    OP(0,0,-2) OP(0,1,-1) OP(0,2,0) \
+    OP(1,0,-1) OP(1,1,1)  OP(1,2,1) \
+    OP(2,0,0)  OP(2,1,1)  OP(2,2,2)
+IP_CONVOLUTION(emboss, 3, 1, 1, K_EMBOSS)
+
+/* Laplacian, offset to mid level
+ * [  0 -1  0 ]
+ * [ -1  4 -1 ]
+ * [  0 -1  0 ]
+ */
+#define K_LAPLACIAN(OP) \
+    OP(0,0,0)  OP(0,1,-1) OP(0,2,0) \
+    OP(1,0,-1) OP(1,1,4)  OP(1,2,-1) \
+    OP(2,0,0)  OP(2,1,-1) OP(2,2,0)
+IP_CONVOLUTION(laplacian, 3, 1, 1, K_LAPLACIAN)
+
+/* Edge enhance
+ * [ -1 -1 -1 ]
+ * [ -1 10 -1 ] / 2
+ * [ -1 -1 -1 ]
+ */
+#define K_EDGE_ENHANCE(OP) \
+    OP(0,0,-1) OP(0,1,-1) OP(0,2,-1) \
+    OP(1,0,-1) OP(1,1,10) OP(1,2,-1) \
+    OP(2,0,-1) OP(2,1,-1) OP(2,2,-1)
+IP_CONVOLUTION(edge_enhance, 3, 2, 0, K_EDGE_ENHANCE)
+
+/* Same weights as ip_sharpen3x3, for comparing the engine against the hand-written filter.
+ * Green is clamped to its real range 0-3 here. */
+#define K_SHARPEN(OP) \
+    OP(0,0,0)  OP(0,1,-1) OP(0,2,0) \
+    OP(1,0,-1) OP(1,1,5)  OP(1,2,-1) \
+    OP(2,0,0)  OP(2,1,-1) OP(2,2,0)
+IP_CONVOLUTION(sharpen3x3_engine, 3, 1, 0, K_SHARPEN)
+
+/* Planar R/G/B images
+ * The packed filters above decode every tap of every window (Sobel: 24 unpacks per pixel),
+ * and neighbouring windows decode the same pixels again. A planar image holds the three
+ * channels as separate byte planes, decoded once by ip_to_planar(); the planar filters then
+ * run each channel kernel directly on plain bytes and only pack at the final store.
+ * If 'out' is not NULL the result is also stored as planes (green masked to 2 bits exactly
+ * like make_rgb does), so planar filters can be stacked without re-decoding. 'out' must not
+ * be 'src'. Output is bit-exact with the packed filters.
+ */
+void ip_to_planar(const unsigned char src[RES_Y][RES_X], ip_planar_t *p) {
+    for (int y = 0; y < RES_Y; ++y)
+        for (int x = 0; x < RES_X; ++x) {
+            unsigned char s = src[y][x];
+            p->r[y][x] = get_red(s);
+            p->g[y][x] = get_green(s);
+            p->b[y][x] = get_blue(s);
+        }
+}
+
+void ip_from_planar(const ip_planar_t *p, volatile unsigned char *dst) {
+    if (!dst) return;
+    for (int y = 0; y < RES_Y; ++y)
+        for (int x = 0; x < RES_X; ++x)
+            dst_write(dst, y, x, make_rgb(p->r[y][x], p->g[y][x], p->b[y][x]));
+}
+
+// Single-channel cores on plane rows (pointers at column x-1), clamped to 'lim'
+typedef unsigned char (*chan3x3_fn)(const unsigned char *t, const unsigned char *m, const unsigned char *b, int lim);
+typedef void (*plane_row_fn)(const unsigned char *t, const unsigned char *m, const unsigned char *b,
+                             unsigned char *out, int lim, int mask);
+
+static inline unsigned char blur_ch(const unsigned char *t, const unsigned char *m, const unsigned char *b, int lim) {
+    int sum = t[0] + t[1] + t[2] + m[0] + m[1] + m[2] + b[0] + b[1] + b[2];
+    return sum / 9;
+}
+
+static inline unsigned char sharpen_ch(const unsigned char *t, const unsigned char *m, const unsigned char *b, int lim) {
+    int v = m[1] * 5 - t[1] - b[1] - m[0] - m[2];
+    return (v < 0) ? 0 : (v > lim) ? lim : v;
+}
+
+static inline unsigned char sobel_ch(const unsigned char *t, const unsigned char *m, const unsigned char *b, int lim) {
+    int gx = -t[0] + t[2] - 2*m[0] + 2*m[2] - b[0] + b[2];
+    int gy = -t[0] - 2*t[1] - t[2] + b[0] + 2*b[1] + b[2];
+    int mag = ((gx < 0 ? -gx : gx) + (gy < 0 ? -gy : gy)) / 8;
+    return (mag > lim) ? lim : mag;
+}
+
+static unsigned char edge_ch_3x3(const unsigned char *t, const unsigned char *m, const unsigned char *b, int x, int lim, chan3x3_fn core) {
+    unsigned char win[3][3];
+    fill_window_3x3(t, m, b, x, win);
+    return core(win[0], win[1], win[2], lim);
+}
+
+// Define name##_plane_row(): one output row of one channel
+#define IP_PLANE_ROW_3X3(name)                                                                  \
+    static void name##_plane_row(const unsigned char *t, const unsigned char *m,                \
+                                 const unsigned char *b, unsigned char *out, int lim, int mask) { \
+        out[0] = edge_ch_3x3(t, m, b, 0, lim, name##_ch) & mask;                                \
+        for (int x = 1; x < RES_X - 1; ++x)                                                     \
+            out[x] = name##_ch(t + x - 1, m + x - 1, b + x - 1, lim) & mask;                    \
+        out[RES_X - 1] = edge_ch_3x3(t, m, b, RES_X - 1, lim, name##_ch) & mask;                \
+    }
+
+IP_PLANE_ROW_3X3(blur)
+IP_PLANE_ROW_3X3(sharpen)
+IP_PLANE_ROW_3X3(sobel)
+
+static void run_planar_3x3(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out, plane_row_fn row) {
+    // Clamp limits and stored masks per channel, matching the packed filters + make_rgb
+    static const int lim[3]  = { 7, 7, 3 };
+    static const int mask[3] = { 7, 3, 3 };
+    static unsigned char tmp[3][RES_X];
+    const unsigned char (*planes[3])[RES_X] = { src->r, src->g, src->b };
+
+    for (int y = 0; y < RES_Y; ++y) {
+        unsigned char *o[3];
+        o[0] = out ? out->r[y] : tmp[0];
+        o[1] = out ? out->g[y] : tmp[1];
+        o[2] = out ? out->b[y] : tmp[2];
+        for (int c = 0; c < 3; ++c) {
+            const unsigned char (*p)[RES_X] = planes[c];
+            const unsigned char *t = (y > 0) ? p[y - 1] : row_at(p, -1);
+            const unsigned char *b = (y < RES_Y - 1) ? p[y + 1] : row_at(p, RES_Y);
+            row(t, p[y], b, o[c], lim[c], mask[c]);
+        }
+        volatile unsigned char *d = dst + y * RES_X;
+        for (int x = 0; x < RES_X; ++x)
+            d[x] = (o[0][x] << 5) | (o[1][x] << 3) | (o[2][x] << 1);
+    }
+}
+
+void ip_blur3x3_planar(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out) {
+    if (!dst) return;
+    run_planar_3x3(src, dst, out, blur_plane_row);
+}
+
+void ip_sharpen3x3_planar(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out) {
+    if (!dst) return;
+    run_planar_3x3(src, dst, out, sharpen_plane_row);
+}
+
+void ip_sobel_planar(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out) {
+    if (!dst) return;
+    run_planar_3x3(src, dst, out, sobel_plane_row);
+}
+
+/* Fused filter chains
+ * Runs an ordered list of stages in one sweep over the image. Each source row is pushed
+ * through the stages as soon as it is read: point stages and the mirror transform the row
+ * right away, 3x3 stages keep a ring of their last three input rows and emit one row behind.
+ * The only intermediate storage is a few rows per stage (see chain_ring / chain_row), so
+ * there is no full-frame traffic between stages and the working set stays cache-sized.
+ *
+ * Every source row is consumed (copied into a ring or transformed) before any output row at
+ * or above it is written, so 'keep' may be 'src' for in-place stacking.
+ * Under IP_EDGE_WRAP the rows above the first and below the last are clamped, since the
+ * opposite edge has not been produced yet when streaming.
+ */
+static unsigned char chain_ring[IP_CHAIN_MAX][3][RES_X]; // input rows of each 3x3 stage
+static unsigned char chain_row[IP_CHAIN_MAX][RES_X];     // output row of stages not feeding a 3x3 stage
+
+static const ip_stage_t *chain_stages;
+static int chain_n;
+static const unsigned char *chain_luts[IP_CHAIN_MAX];
+static volatile unsigned char *chain_dst;
+static unsigned char (*chain_keep)[RES_X];
+
+static inline int stage_is_3x3(int k) {
+    return chain_stages[k].kind >= IP_STAGE_BLUR;
+}
+
+// Where stage k writes its output row y: straight into the next 3x3 stage's ring, or a row buffer
+static inline unsigned char *chain_out(int k, int y) {
+    if (k + 1 < chain_n && stage_is_3x3(k + 1)) return chain_ring[k + 1][y % 3];
+    return chain_row[k];
+}
+
+static void chain_feed(int k, int y, const unsigned char *in);
+
+// Stage k has written output row y into chain_out(k, y): pass it on
+static void chain_emit(int k, int y) {
+    const unsigned char *row = chain_out(k, y);
+    if (k + 1 < chain_n) {
+        chain_feed(k + 1, y, row);
+        return;
+    }
+    volatile unsigned char *d = chain_dst + y * RES_X;
+    for (int x = 0; x < RES_X; ++x) d[x] = row[x];
+    if (chain_keep)
+        for (int x = 0; x < RES_X; ++x) chain_keep[y][x] = row[x];
+}
+
+static void chain_run_3x3(int k, int y, const unsigned char *t, const unsigned char *m, const unsigned char *b) {
+    unsigned char *out = chain_out(k, y);
+    switch (chain_stages[k].kind) {
+        case IP_STAGE_BLUR:    blur_row(t, m, b, out); break;
+        case IP_STAGE_SHARPEN: sharpen_row(t, m, b, out); break;
+        case IP_STAGE_SOBEL:   sobel_row(t, m, b, out); break;
+        default: return;
+    }
+    chain_emit(k, y);
+}
+
+// Input row y of stage k. For 3x3 stages 'in' is already chain_ring[k][y % 3].
+static void chain_feed(int k, int y, const unsigned char *in) {
+    unsigned char (*ring)[RES_X] = chain_ring[k];
+    switch (chain_stages[k].kind) {
+        case IP_STAGE_LUT: {
+            const unsigned char *lut = chain_luts[k];
+            unsigned char *out = chain_out(k, y);
+            for (int x = 0; x < RES_X; ++x) out[x] = lut[in[x]];
+            chain_emit(k, y);
+            break;
+        }
+        case IP_STAGE_MIRROR:
+            mirror_row(in, chain_out(k, y));
+            chain_emit(k, y);
+            break;
+        default:
+            if (y >= 1) {
+#if IP_EDGE_POLICY == IP_EDGE_ZERO
+                const unsigned char *top = zero_row;
+#elif IP_EDGE_POLICY == IP_EDGE_MIRROR
+                const unsigned char *top = ring[1];
+#else
+                const unsigned char *top = ring[0];
+#endif
+                if (y >= 2) top = ring[(y - 2) % 3];
+                chain_run_3x3(k, y - 1, top, ring[(y - 1) % 3], ring[y % 3]);
+            }
+            if (y == RES_Y - 1) {
+#if IP_EDGE_POLICY == IP_EDGE_ZERO
+                const unsigned char *bottom = zero_row;
+#elif IP_EDGE_POLICY == IP_EDGE_MIRROR
+                const unsigned char *bottom = ring[(y - 1) % 3];
+#else
+                const unsigned char *bottom = ring[y % 3];
+#endif
+                chain_run_3x3(k, y, ring[(y - 1) % 3], ring[y % 3], bottom);
+            }
+            break;
+    }
+}
+
+void ip_run_chain(const ip_stage_t *stages, int n, const unsigned char src[RES_Y][RES_X],
+                  volatile unsigned char *dst, unsigned char keep[RES_Y][RES_X]) {
+    if (!dst || n < 0 || n > IP_CHAIN_MAX) return;
+    if (n == 0) {
+        // Nothing to fuse, plain copy
+        for (int y = 0; y < RES_Y; ++y)
+            for (int x = 0; x < RES_X; ++x) {
+                dst[y * RES_X + x] = src[y][x];
+                if (keep) keep[y][x] = src[y][x];
+            }
+        return;
+    }
+
+    chain_stages = stages;
+    chain_n = n;
+    chain_dst = dst;
+    chain_keep = keep;
+    for (int k = 0; k < n; ++k)
+        chain_luts[k] = (stages[k].kind == IP_STAGE_LUT) ? stages[k].lut() : 0;
+
+    for (int y = 0; y < RES_Y; ++y) {
+        if (stage_is_3x3(0)) {
+            unsigned char *slot = chain_ring[0][y % 3];
+            for (int x = 0; x < RES_X; ++x) slot[x] = src[y][x];
+            chain_feed(0, y, slot);
+        } else {
+            chain_feed(0, y, src[y]);
+        }
+    }
+}
@@ -5,6 +5,18 @@
 
 #include "vga.h"
 
+// Edge policy for the 3x3 neighbourhood filters (blur, sharpen, sobel).
+// Chosen at compile time, e.g. add -DIP_EDGE_POLICY=IP_EDGE_MIRROR to CFLAGS.
+// Only the one-pixel border is affected; the interior loops never check edges.
+#define IP_EDGE_CLAMP   0   // replicate the nearest edge pixel (default)
+#define IP_EDGE_MIRROR  1   // reflect around the edge pixel: -1 -> 1
+#define IP_EDGE_WRAP    2   // wrap around to the opposite edge
+#define IP_EDGE_ZERO    3   // treat pixels outside the image as 0 (black)
+
+#ifndef IP_EDGE_POLICY
+#define IP_EDGE_POLICY  IP_EDGE_CLAMP
+#endif
+
 // Apply filters. 'src' is a pointer to the top-left of a RES_Y x RES_X image
 // laid out row-major (we'll pass Bliss or a pointer to the Bliss array).
 // 'dst' is a pointer to the output framebuffer (volatile so it can be VGA).
@@ -18,4 +30,220 @@ void ip_blur3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *d
 void ip_sharpen3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
 void ip_sobel(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
 
+// Chamfer 3-4 distance to the nearest white (features_white) or black pixel, and its display
+void ip_chamfer(const unsigned char src[RES_Y][RES_X], unsigned short dist[RES_Y][RES_X], int features_white);
+void ip_distance(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// Point filters (one table lookup per pixel)
+void ip_sepia(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_posterize(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_red_only(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_green_only(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_blue_only(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_gamma(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// Median filter, constant time per pixel for any radius up to IP_MEDIAN_MAX_RADIUS
+#define IP_MEDIAN_MAX_RADIUS 7
+void ip_median(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+void ip_median3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_median5x5(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// Box blur and three-pass approximate Gaussian, constant cost per pixel for any radius
+#define IP_BOX_MAX_RADIUS 15
+void ip_box_blur(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+void ip_gaussian_approx(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+
+// Unsharp mask: orig + amount / IP_UNSHARP_ONE * (orig - blurred); dst may alias src.
+// The caller owns the blurred copy (the UI keeps it across amount changes).
+#define IP_UNSHARP_ONE 4
+void ip_unsharp_apply(const unsigned char src[RES_Y][RES_X], const unsigned char blurred[RES_Y][RES_X],
+                      volatile unsigned char *dst, int amount);
+
+// Integral image of 8-bit luma; rectangle [x0,x1) x [y0,y1) sums in four loads
+typedef struct {
+    unsigned int sum[RES_Y + 1][RES_X + 1];
+} ip_integral_t;
+
+void ip_integral_build(const unsigned char src[RES_Y][RES_X], ip_integral_t *ii);
+
+static inline unsigned int ip_integral_rect(const ip_integral_t *ii, int x0, int y0, int x1, int y1) {
+    return ii->sum[y1][x1] - ii->sum[y1][x0] - ii->sum[y0][x1] + ii->sum[y0][x0];
+}
+
+// Mean luma of the (2r+1)^2 box around (cx, cy), clipped to the image; O(1) for any r
+unsigned int ip_integral_mean(const ip_integral_t *ii, int cx, int cy, int radius);
+
+// Bradley adaptive threshold: white where luma > (100 - percent)% of the local mean
+#define IP_ADAPTIVE_MAX_RADIUS 30
+#define IP_ADAPTIVE_PERCENT    15
+void ip_adaptive_threshold(const ip_integral_t *ii, const unsigned char src[RES_Y][RES_X],
+                           volatile unsigned char *dst, int radius, int percent);
+
+// Single-sweep statistics: histograms, and per channel min, max and mean (8.8 fixed point)
+#define IP_STATS_R        0
+#define IP_STATS_G        1
+#define IP_STATS_B        2
+#define IP_STATS_LUMA     3
+#define IP_STATS_CHANNELS 4
+
+typedef struct {
+    unsigned int hist_r[8];
+    unsigned int hist_g[4];
+    unsigned int hist_b[4];
+    unsigned int hist_luma[256];
+    unsigned char min[IP_STATS_CHANNELS];
+    unsigned char max[IP_STATS_CHANNELS];
+    unsigned int mean[IP_STATS_CHANNELS];
+} ip_stats_t;
+
+void ip_stats(const unsigned char src[RES_Y][RES_X], ip_stats_t *st);
+int ip_otsu_level(const ip_stats_t *st);
+
+// Remap tables built from the statistics, for ip_apply_lut
+void ip_autolevels_table(const ip_stats_t *st, unsigned char lut[256]);
+void ip_equalize_table(const ip_stats_t *st, unsigned char lut[256]);
+void ip_otsu_table(const ip_stats_t *st, unsigned char lut[256]);
+
+// Statistics pass plus table pass
+void ip_autolevels(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_equalize(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_otsu(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// Contrast-limited adaptive histogram equalization over IP_CLAHE_TILE-square tiles
+#define IP_CLAHE_TILE 40   // must divide RES_X and RES_Y (8x6 tiles)
+#define IP_CLAHE_CLIP 2    // histogram clip limit, in multiples of the mean bin count
+void ip_clahe(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// Dithered grayscale (8 levels) and black & white: Floyd-Steinberg and 4x4 Bayer ordered
+void ip_dither_fs_gray(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_dither_fs_bw(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_dither_ordered_gray(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_dither_ordered_bw(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// Binary image, 1 bit per pixel (bit i of word j = pixel 32j + i); set = white in ip_blackwhite
+#define IP_BIN_WORDS      (RES_X / 32)
+#define IP_BIN_MAX_RADIUS 31
+typedef struct {
+    unsigned int w[RES_Y][IP_BIN_WORDS];
+} ip_binary_t;
+
+void ip_to_binary(const unsigned char src[RES_Y][RES_X], ip_binary_t *bin);
+void ip_from_binary(const ip_binary_t *bin, volatile unsigned char *dst);
+
+// Morphology with a (2r+1)^2 square, clipped at the border; dst may alias src
+void ip_bin_erode(const ip_binary_t *src, ip_binary_t *dst, int radius);
+void ip_bin_dilate(const ip_binary_t *src, ip_binary_t *dst, int radius);
+void ip_bin_open(const ip_binary_t *src, ip_binary_t *dst, int radius);
+void ip_bin_close(const ip_binary_t *src, ip_binary_t *dst, int radius);
+
+// Black & white followed by one morphology operation, output 0/255
+void ip_erode(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+void ip_dilate(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+void ip_open(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+void ip_close(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+
+// Connected components (8-connectivity) of a binary image, labelled per run
+#define IP_CCL_MAX_RUNS  (RES_Y * (RES_X / 2))   // a row holds at most RES_X / 2 runs
+#define IP_CCL_MAX_BLOBS 4096
+#define IP_CCL_NO_BLOB   0xFFFF                   // label of runs in components past the cap
+typedef struct {
+    unsigned short x0, x1, y;   // pixels x0..x1 of row y
+    unsigned short label;
+} ip_run_t;
+
+typedef struct {
+    unsigned short x0, y0, x1, y1;  // inclusive bounding box
+    unsigned int area;
+} ip_blob_t;
+
+typedef struct {
+    int n_runs;
+    int n_blobs;                    // components in blobs[], in raster order of their first run
+    int n_dropped;                  // components past IP_CCL_MAX_BLOBS, labelled IP_CCL_NO_BLOB
+    ip_run_t runs[IP_CCL_MAX_RUNS];
+    ip_blob_t blobs[IP_CCL_MAX_BLOBS];
+} ip_ccl_t;
+
+// Labels into the labeller's single workspace; the result is valid until the next
+// ip_label() or ip_canny(), which shares the workspace
+const ip_ccl_t *ip_label(const ip_binary_t *bin);
+void ip_draw_blobs(const ip_ccl_t *ccl, volatile unsigned char *dst, unsigned int min_area);  // box outlines
+
+// Canny edges on luma (thin white edges on black); thresholds on |gx| + |gy|, at most 2040
+#define IP_CANNY_LOW  96
+#define IP_CANNY_HIGH 192
+void ip_canny(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_canny_thresholds(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int low, int high);
+
+// Edge-preserving bilateral smoothing, table driven (radius 1-3)
+#define IP_BILATERAL_MAX_RADIUS 3
+#define IP_BILATERAL_SIGMA_R    64   // range sigma, on channels expanded to 0-255
+void ip_bilateral(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+
+// Kernels generated by the compile-time convolution engine
+void ip_gaussian3x3(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_gaussian5x5(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_box5x5(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_emboss(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_laplacian(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_edge_enhance(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_sharpen3x3_engine(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// SWAR word-at-a-time variants (bit-exact with the byte versions, 4 pixels per load/store)
+void ip_invert_swar(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_blackwhite_swar(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+void ip_mirror_swar(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+
+// LUT engine. dst may alias src (in-place apply).
+void ip_apply_lut(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, const unsigned char lut[256]);
+void ip_compose_lut(const unsigned char first[256], const unsigned char second[256], unsigned char out[256]);
+
+// 256-entry tables of the point filters, built once on first use
+const unsigned char *ip_lut_grayscale(void);
+const unsigned char *ip_lut_blackwhite(void);
+const unsigned char *ip_lut_invert(void);
+const unsigned char *ip_lut_sepia(void);
+const unsigned char *ip_lut_posterize(void);
+const unsigned char *ip_lut_red_only(void);
+const unsigned char *ip_lut_green_only(void);
+const unsigned char *ip_lut_blue_only(void);
+const unsigned char *ip_lut_gamma(void);
+
+// Planar image: the three channels of a 3-2-2 image as separate byte planes
+typedef struct {
+    unsigned char r[RES_Y][RES_X];   // 0-7
+    unsigned char g[RES_Y][RES_X];   // 0-3
+    unsigned char b[RES_Y][RES_X];   // 0-3
+} ip_planar_t;
+
+void ip_to_planar(const unsigned char src[RES_Y][RES_X], ip_planar_t *p);
+void ip_from_planar(const ip_planar_t *p, volatile unsigned char *dst);
+
+// Neighbourhood filters on planes, packed only at the store into 'dst'.
+// 'out' (optional, not 'src') also receives the result as planes for stacking.
+void ip_blur3x3_planar(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out);
+void ip_sharpen3x3_planar(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out);
+void ip_sobel_planar(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out);
+
+// Fused filter chains: an ordered list of stages run in a single sweep over the image,
+// keeping only a few rows per stage instead of full-frame intermediates.
+typedef enum {
+    IP_STAGE_LUT,       // point filter, table from 'lut'
+    IP_STAGE_MIRROR,
+    IP_STAGE_BLUR,      // 3x3 stages from here on
+    IP_STAGE_SHARPEN,
+    IP_STAGE_SOBEL
+} ip_stage_kind_t;
+
+typedef struct {
+    ip_stage_kind_t kind;
+    const unsigned char *(*lut)(void); // IP_STAGE_LUT only, e.g. ip_lut_invert
+} ip_stage_t;
+
+#define IP_CHAIN_MAX 8
+
+// Result goes to 'dst' and, if 'keep' is not NULL, also to 'keep' (which may be 'src').
+void ip_run_chain(const ip_stage_t *stages, int n, const unsigned char src[RES_Y][RES_X],
+                  volatile unsigned char *dst, unsigned char keep[RES_Y][RES_X]);
+
 #endif // IMAGEPROC_H
@@ -49,6 +49,7 @@ int main(void) {
 #ifdef RUN_PERFORMANCE_TESTS
   // Performance test mode
   print("=== PERFORMANCE TEST MODE ===\n");
+  perf_init();
   test_filter_performance("Grayscale", ip_grayscale);
   test_filter_performance("Black & White", ip_blackwhite);
   test_filter_performance("Invert", ip_invert);
@@ -56,6 +57,62 @@ int main(void) {
   test_filter_performance("Blur 3x3", ip_blur3x3);
   test_filter_performance("Sharpen 3x3", ip_sharpen3x3);
   test_filter_performance("Sobel", ip_sobel);
+  test_filter_performance("Black & White (SWAR)", ip_blackwhite_swar);
+  test_filter_performance("Invert (SWAR)", ip_invert_swar);
+  test_filter_performance("Mirror (SWAR)", ip_mirror_swar);
+  test_planar_performance("Blur 3x3 (planar)", ip_blur3x3_planar);
+  test_planar_performance("Sharpen 3x3 (planar)", ip_sharpen3x3_planar);
+  test_planar_performance("Sobel (planar)", ip_sobel_planar);
+  test_filter_performance("Median 3x3", ip_median3x3);
+  test_filter_performance("Median 5x5", ip_median5x5);
+  // Running-sum box blur, 3-pass Gaussian and 1bpp erosion: cycles should stay flat as the radius grows
+  static const int radii[] = { 1, 2, 4, 8, IP_BOX_MAX_RADIUS };
+  for (int i = 0; i < 5; ++i) {
+    test_radius_performance("Box blur", ip_box_blur, radii[i]);
+    test_radius_performance("Gaussian (3 box passes)", ip_gaussian_approx, radii[i]);
+    test_radius_performance("Erode (1bpp)", ip_erode, radii[i]);
+  }
+  test_adaptive_performance("Adaptive threshold (r = 20)", 20);
+  test_label_performance("Label blobs (runs)");
+  test_filter_performance("Distance glow (2x chamfer)", ip_distance);
+  test_filter_performance("Canny (luma)", ip_canny);
+  // Edge-preserving smoothing vs. the plain 3x3 blur
+  test_filter_performance("Blur 3x3", ip_blur3x3);
+  for (int r = 1; r <= IP_BILATERAL_MAX_RADIUS; ++r)
+    test_radius_performance("Bilateral", ip_bilateral, r);
+  test_unsharp_performance("Unsharp (r = 2, amount 1.0)", 2, IP_UNSHARP_ONE);
+  test_blit_performance();
+  // Menu switches write only the pixels that differ between the two screens
+  test_transition_performance("Menu transition main -> upload", &asset_main_menu, &asset_upload_menu);
+  test_transition_performance("Menu transition upload -> process", &asset_upload_menu, &asset_process_menu);
+  // Assets are decoded on demand: RLE menus, LZ photos
+  test_decode_performance("Decode main menu (RLE)", &asset_main_menu);
+  test_decode_performance("Decode process menu (RLE)", &asset_process_menu);
+  test_decode_performance("Decode Bliss (LZ)", &asset_bliss);
+  test_decode_performance("Decode KTH (LZ)", &asset_kth);
+  // Statistics sweep plus remap table, expected close to the point filters
+  test_filter_performance("Auto levels (stats)", ip_autolevels);
+  test_filter_performance("Equalize (stats)", ip_equalize);
+  test_filter_performance("Otsu B&W (stats)", ip_otsu);
+  test_filter_performance("CLAHE (8x6 tiles)", ip_clahe);
+  test_filter_performance("Gray (Floyd-Steinberg)", ip_dither_fs_gray);
+  test_filter_performance("B&W (Floyd-Steinberg)", ip_dither_fs_bw);
+  test_filter_performance("Gray (ordered dither)", ip_dither_ordered_gray);
+  test_filter_performance("B&W (ordered dither)", ip_dither_ordered_bw);
+  test_filter_performance("Sharpen 3x3 (engine)", ip_sharpen3x3_engine);
+  test_filter_performance("Gaussian 3x3 (engine)", ip_gaussian3x3);
+  test_filter_performance("Gaussian 5x5 (engine)", ip_gaussian5x5);
+  test_filter_performance("Box 5x5 (engine)", ip_box5x5);
+  test_filter_performance("Emboss (engine)", ip_emboss);
+  test_filter_performance("Laplacian (engine)", ip_laplacian);
+  test_filter_performance("Edge enhance (engine)", ip_edge_enhance);
+  test_filter_performance("Sepia (LUT)", ip_sepia);
+  test_filter_performance("Posterize (LUT)", ip_posterize);
+  test_filter_performance("Gamma (LUT)", ip_gamma);
+
+  // Same three filters as separate passes above vs. fused into one sweep
+  static const ip_stage_t fused[] = { { IP_STAGE_BLUR, 0 }, { IP_STAGE_SHARPEN, 0 }, { IP_STAGE_SOBEL, 0 } };
+  test_chain_performance("Blur+Sharpen+Sobel (fused)", fused, 3);
   print("=== TESTS COMPLETE ===\n");
   print("Now entering normal UI mode...\n");
 
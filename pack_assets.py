@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+# pack_assets.py
+#
+# Generates background.c from the raw art in background_raw.inc:
+# menus and flat art are RLE coded, photos LZ coded (formats in assets.h),
+# sprites are kept raw since they are drawn from directly.
+#
+# Usage: python3 pack_assets.py [background_raw.inc] [background.c]
+
+import re
+import sys
+
+# raw array -> (asset name, codec)
+ASSETS = [
+    ("test1",            "asset_test1",        "ASSET_RLE"),
+    ("Bliss",            "asset_bliss",        "ASSET_LZ"),
+    ("KTH",              "asset_kth",          "ASSET_LZ"),
+    ("Icecream",         "asset_icecream",     "ASSET_LZ"),
+    ("mainMenuStyle",    "asset_main_menu",    "ASSET_RLE"),
+    ("uploadMenuStyle",  "asset_upload_menu",  "ASSET_RLE"),
+    ("processMenuStyle", "asset_process_menu", "ASSET_RLE"),
+]
+SPRITES = ["handSprite", "arrowSprite"]
+
+RLE_MAX_LITERAL = 128   # control 0x00..0x7F: 1..128 literals
+RLE_MIN_RUN = 3         # shorter runs are cheaper as literals
+RLE_MAX_RUN = 129       # control 0x80..0xFF: runs of 2..129
+
+LZ_MIN_MATCH = 3
+LZ_WINDOW = 65535
+LZ_DEPTH = 256          # match candidates tried per position
+
+
+def parse_arrays(text):
+    arrays = {}
+    pattern = r'^((?:const )?unsigned char (\w+)\[\w+\]\[\w+\] = \{.*?\};)'
+    for m in re.finditer(pattern, text, re.S | re.M):
+        body = m.group(1).split("=", 1)[1]
+        body = re.sub(r'//[^\n]*', '', body)
+        body = re.sub(r'/\*.*?\*/', '', body, flags=re.S)
+        values = [int(v, 0) for v in re.findall(r'0x[0-9a-fA-F]+|\d+', body)]
+        arrays[m.group(2)] = (m.group(1), bytes(values))
+    return arrays
+
+
+def rle_encode(data):
+    out = bytearray()
+    literals = bytearray()
+
+    def flush():
+        nonlocal literals
+        while literals:
+            chunk = literals[:RLE_MAX_LITERAL]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+            literals = literals[RLE_MAX_LITERAL:]
+
+    i = 0
+    while i < len(data):
+        j = i
+        while j < len(data) and data[j] == data[i] and j - i < RLE_MAX_RUN:
+            j += 1
+        if j - i >= RLE_MIN_RUN:
+            flush()
+            out.append(0x80 | (j - i - 2))
+            out.append(data[i])
+            i = j
+        else:
+            literals.append(data[i])
+            i += 1
+    flush()
+    return bytes(out)
+
+
+def lz_length(n, out):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz_encode(data):
+    n = len(data)
+    out = bytearray()
+    chains = {}
+
+    def insert(p):
+        if p + LZ_MIN_MATCH <= n:
+            chains.setdefault(data[p:p + LZ_MIN_MATCH], []).append(p)
+
+    def longest(p):
+        best, best_off = 0, 0
+        if p + LZ_MIN_MATCH > n:
+            return 0, 0
+        for q in reversed(chains.get(data[p:p + LZ_MIN_MATCH], [])[-LZ_DEPTH:]):
+            if p - q > LZ_WINDOW:
+                break
+            l = 0
+            while p + l < n and data[q + l] == data[p + l]:
+                l += 1
+            if l > best:
+                best, best_off = l, p - q
+        return best, best_off
+
+    def sequence(literals, match, offset):
+        token = min(len(literals), 15) << 4
+        if match:
+            token |= min(match - LZ_MIN_MATCH, 15)
+        out.append(token)
+        if len(literals) >= 15:
+            lz_length(len(literals) - 15, out)
+        out.extend(literals)
+        if match:
+            out.append(offset & 0xFF)
+            out.append(offset >> 8)
+            if match - LZ_MIN_MATCH >= 15:
+                lz_length(match - LZ_MIN_MATCH - 15, out)
+
+    i = start = 0
+    while i < n:
+        match, offset = longest(i)
+        # Lazy matching: a literal now may buy a longer match at the next pixel
+        if match >= LZ_MIN_MATCH and longest(i + 1)[0] <= match + 1:
+            sequence(data[start:i], match, offset)
+            for p in range(i, i + match):
+                insert(p)
+            i += match
+            start = i
+        else:
+            insert(i)
+            i += 1
+    sequence(data[start:n], 0, 0)
+    return bytes(out)
+
+
+def rle_decode(code, n):
+    out = bytearray()
+    i = 0
+    while len(out) < n:
+        c = code[i]
+        if c < 0x80:
+            out.extend(code[i + 1:i + 2 + c])
+            i += 2 + c
+        else:
+            out.extend(bytes([code[i + 1]]) * ((c & 0x7F) + 2))
+            i += 2
+    return bytes(out)
+
+
+def lz_decode(code, n):
+    out = bytearray()
+    i = 0
+    while True:
+        token = code[i]
+        i += 1
+        literals = token >> 4
+        if literals == 15:
+            while True:
+                literals += code[i]
+                i += 1
+                if code[i - 1] != 255:
+                    break
+        out.extend(code[i:i + literals])
+        i += literals
+        if len(out) >= n:
+            return bytes(out)
+        offset = code[i] | (code[i + 1] << 8)
+        i += 2
+        match = token & 15
+        if match == 15:
+            while True:
+                match += code[i]
+                i += 1
+                if code[i - 1] != 255:
+                    break
+        for _ in range(match + LZ_MIN_MATCH):
+            out.append(out[-offset])
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    src = sys.argv[1] if len(sys.argv) > 1 else "background_raw.inc"
+    dst = sys.argv[2] if len(sys.argv) > 2 else "background.c"
+    arrays = parse_arrays(open(src).read())
+
+    out = ["// background.c",
+           "// Generated by pack_assets.py from background_raw.inc, do not edit.",
+           "",
+           '#include "vga.h"',
+           '#include "background.h"',
+           "",
+           "// Sprites, raw"]
+    for name in SPRITES:
+        out.append(arrays[name][0])
+        out.append("")
+
+    out.append("// Images and menus, compressed (see assets.h)")
+    total_raw = total_packed = 0
+    for name, asset, codec in ASSETS:
+        raw = arrays[name][1]
+        if codec == "ASSET_RLE":
+            packed = rle_encode(raw)
+            assert rle_decode(packed, len(raw)) == raw
+        else:
+            packed = lz_encode(raw)
+            assert lz_decode(packed, len(raw)) == raw
+        total_raw += len(raw)
+        total_packed += len(packed)
+        print("%-18s %-9s %6d -> %6d bytes" % (name, codec[6:], len(raw), len(packed)))
+        out.append("static const unsigned char %s_data[%d] = {" % (name, len(packed)))
+        out.append(c_bytes(packed))
+        out.append("};")
+        out.append("const asset_t %s = { %s, %d, %s_data };" % (asset, codec, len(packed), name))
+        out.append("")
+    print("total              %6d -> %6d bytes" % (total_raw, total_packed))
+
+    with open(dst, "w") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
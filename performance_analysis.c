@@ -2,6 +2,7 @@
 #include "dtekv-lib.h"
 #include "background.h"
 #include "vga.h"
+#include "blit.h"
 
 /* --- GLOBAL COUNTERS --- */
 struct perf_counters before, after, delta;
@@ -126,10 +127,175 @@ void present_data(const char* filter_name) {
     print("Execution Time (ms): "); print_dec(execution_time_ms); printc('\n');
 }
 
+/* Source image of the filter tests, decoded from its asset by perf_init() */
+static unsigned char perf_image[RES_Y][RES_X];
+
+void perf_init(void) {
+    asset_decode(&asset_bliss, (volatile unsigned char *)perf_image);
+}
+
 /* Test performance of a specific filter */
 void test_filter_performance(const char* filter_name, 
     void (*filter_func)(const unsigned char[][320], volatile unsigned char*)) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    filter_func(perf_image, dst);
+    present_data(filter_name);
+}
+
+/* Test performance of a fused filter chain (single sweep) */
+void test_chain_performance(const char* chain_name, const ip_stage_t *stages, int n) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    ip_run_chain(stages, n, perf_image, dst, 0);
+    present_data(chain_name);
+}
+
+/* Test performance of a filter that takes a radius; the radius is printed
+ * before the counters so sweeps over several radii can be compared. */
+void test_radius_performance(const char* filter_name,
+    void (*filter_func)(const unsigned char[][320], volatile unsigned char*, int), int radius) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    filter_func(perf_image, dst, radius);
+    print("Radius: "); print_dec(radius); printc('\n');
+    present_data(filter_name);
+}
+
+/* Test performance of the adaptive threshold. Building the integral image is measured
+ * separately since the UI only pays it once per image; threshold tweaks only pay the
+ * final pass. */
+static ip_integral_t perf_integral;
+
+void test_adaptive_performance(const char* filter_name, int radius) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    ip_integral_build(perf_image, &perf_integral);
+    present_data("Integral image");
+
+    before_perf();
+    ip_adaptive_threshold(&perf_integral, perf_image, dst, radius, IP_ADAPTIVE_PERCENT);
+    present_data(filter_name);
+}
+
+/* Test performance of connected-component labelling, thresholding included; compare
+ * with the Sobel pass. */
+static ip_binary_t perf_mask;
+
+void test_label_performance(const char* filter_name) {
+    before_perf();
+    ip_to_binary(perf_image, &perf_mask);
+    const ip_ccl_t *labels = ip_label(&perf_mask);
+    present_data(filter_name);
+    print("Blobs: "); print_dec(labels->n_blobs);
+    print(", runs: "); print_dec(labels->n_runs); printc('\n');
+}
+
+/* Test performance of the unsharp mask. The blur is measured separately since the UI
+ * keeps the blurred copy and only re-runs the table pass when the amount changes. */
+static unsigned char perf_blurred[RES_Y][RES_X];
+
+void test_unsharp_performance(const char* filter_name, int radius, int amount) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    ip_box_blur(perf_image, (volatile unsigned char *)perf_blurred, radius);
+    present_data("Unsharp blur (box)");
+
     before_perf();
-    filter_func(Bliss, BUF0);
+    ip_unsharp_apply(perf_image, perf_blurred, dst, amount);
     present_data(filter_name);
-}
\ No newline at end of file
+}
+
+/* Test performance of a planar filter. The packed-to-planar conversion is
+ * measured separately since the UI only pays it once per loaded image. */
+static ip_planar_t perf_planes, perf_planes_out;
+
+void test_planar_performance(const char* filter_name,
+    void (*planar_func)(const ip_planar_t*, volatile unsigned char*, ip_planar_t*)) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    ip_to_planar(perf_image, &perf_planes);
+    present_data("To planar");
+
+    before_perf();
+    planar_func(&perf_planes, dst, &perf_planes_out);
+    present_data(filter_name);
+}
+
+/* Test performance of a menu transition: decoding the whole menu against writing only
+ * the difference spans. Building the spans is measured separately since the UI does
+ * it once at boot. */
+#define PERF_MAX_SPANS  1024
+#define PERF_MAX_PIXELS 24576
+static vga_span_t perf_spans[PERF_MAX_SPANS];
+static unsigned char perf_pixels[2][PERF_MAX_PIXELS];
+
+void test_transition_performance(const char* name, const asset_t *from, const asset_t *to) {
+    vga_diff_t diff;
+    volatile unsigned char *dst = vga_back_buffer();
+    vga_diff_init(&diff, perf_spans, PERF_MAX_SPANS, perf_pixels[0], perf_pixels[1], PERF_MAX_PIXELS);
+    before_perf();
+    int n = asset_diff(&diff, from, to);
+    present_data("Diff build");
+
+    before_perf();
+    asset_decode(to, dst);
+    present_data("Full redraw (decode)");
+
+    if (n < 0) {
+        print("Too many spans, transition redraws in full\n");
+        return;
+    }
+    before_perf();
+    vga_diff_apply(&diff, 1, dst);
+    print("Spans: "); print_dec(n);
+    print(", pixels: "); print_dec(diff.n_pix); printc('\n');
+    present_data(name);
+}
+
+/* Microbenchmark of the bulk copy and fill routines against the byte loop they replace,
+ * reported as bytes per cycle. */
+static unsigned char perf_frame[RES_Y][RES_X];
+
+static void present_rate(const char* name, unsigned int bytes) {
+    present_data(name);
+    unsigned int rate = delta.mcycle.lo ? bytes * 100 / delta.mcycle.lo : 0;
+    print("Bytes/cycle: "); print_dec(rate / 100); printc('.');
+    printc('0' + (rate / 10) % 10); printc('0' + rate % 10); printc('\n');
+}
+
+void test_blit_performance(void) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    for (int y = 0; y < RES_Y; ++y)
+        for (int x = 0; x < RES_X; ++x)
+            dst[y * RES_X + x] = perf_image[y][x];
+    present_rate("Frame copy (byte loop)", BLIT_FRAME);
+
+    before_perf();
+    blit_frame(dst, perf_image);
+    present_rate("Frame copy to VRAM (blit)", BLIT_FRAME);
+
+    before_perf();
+    blit_frame(perf_frame, dst);
+    present_rate("Frame copy from VRAM (blit)", BLIT_FRAME);
+
+    before_perf();
+    blit_fill(dst, 0, BLIT_FRAME);
+    present_rate("Frame fill (blit)", BLIT_FRAME);
+
+    // Source and destination misaligned against each other: merged from aligned words
+    before_perf();
+    blit_rect(dst + 60 * RES_X + 81, RES_X, &perf_image[10][3], RES_X, 160, 120);
+    present_rate("Rect 160x120 copy, unaligned (blit)", 160 * 120);
+}
+
+/* Test decode throughput of a compressed image, straight into VRAM */
+void test_decode_performance(const char* name, const asset_t *a) {
+    volatile unsigned char *dst = vga_back_buffer();
+    before_perf();
+    asset_decode(a, dst);
+    present_rate(name, BLIT_FRAME);
+    print("Compressed: "); print_dec(a->size);
+    print(" of "); print_dec(BLIT_FRAME); print(" bytes\n");
+}
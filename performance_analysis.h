@@ -3,6 +3,9 @@
 #ifndef PERFORMANCE_ANALYSIS_H
 #define PERFORMANCE_ANALYSIS_H
 
+#include "image_processing.h"
+#include "assets.h"
+
 struct counter64 {
     unsigned int lo;
     unsigned int hi;
@@ -27,7 +30,19 @@ extern struct perf_counters before, after, delta;
 void clear_counters(void);
 void read_counters(struct perf_counters *c);
 void before_perf(void);
+void perf_init(void);
 void present_data(const char* filter_name);
 void test_filter_performance(const char* filter_name, void (*filter_func)(const unsigned char[][320], volatile unsigned char*));
+void test_chain_performance(const char* chain_name, const ip_stage_t *stages, int n);
+void test_radius_performance(const char* filter_name,
+    void (*filter_func)(const unsigned char[][320], volatile unsigned char*, int), int radius);
+void test_adaptive_performance(const char* filter_name, int radius);
+void test_label_performance(const char* filter_name);
+void test_unsharp_performance(const char* filter_name, int radius, int amount);
+void test_transition_performance(const char* name, const asset_t *from, const asset_t *to);
+void test_decode_performance(const char* name, const asset_t *a);
+void test_blit_performance(void);
+void test_planar_performance(const char* filter_name,
+    void (*planar_func)(const ip_planar_t*, volatile unsigned char*, ip_planar_t*));
 
 #endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+// sprite.c
+
+#include "sprite.h"
+
+int sprite_compile(sprite_t *s, const unsigned char *pixels, int w, int h, int stride) {
+    int n = 0, pix = 0;
+    for (int y = 0; y < h; ++y) {
+        const unsigned char *row = pixels + y * stride;
+        int x = 0;
+        while (x < w) {
+            if (row[x] == 0) { x++; continue; }
+            int start = x;
+            while (x < w && row[x] != 0) x++;
+            if (n == SPRITE_MAX_SPANS || pix + (x - start) > SPRITE_MAX_PIXELS) return -1;
+            s->spans[n].dx = start;
+            s->spans[n].dy = y;
+            s->spans[n].len = x - start;
+            s->spans[n].pix = pix;
+            for (int i = start; i < x; ++i)
+                s->pixels[pix++] = row[i];
+            n++;
+        }
+    }
+    s->n_spans = n;
+    return 0;
+}
+
+/* Clip a run to the screen. Returns its length on screen (<= 0 if none) and sets
+ * the first screen offset and how many of its pixels were cut on the left. */
+static inline int sprite_clip(const sprite_span_t *sp, int x, int y, int *offset, int *skip) {
+    int sy = y + sp->dy;
+    if (sy < 0 || sy >= RES_Y) return 0;
+    int x0 = x + sp->dx;
+    int x1 = x0 + sp->len;
+    int cut = 0;
+    if (x0 < 0) { cut = -x0; x0 = 0; }
+    if (x1 > RES_X) x1 = RES_X;
+    *offset = sy * RES_X + x0;
+    *skip = cut;
+    return x1 - x0;
+}
+
+void sprite_draw(sprite_place_t *p, const sprite_t *s, volatile unsigned char *vram, int x, int y) {
+    p->sprite = s;
+    p->vram = vram;
+    p->x = x;
+    p->y = y;
+    for (int i = 0; i < s->n_spans; ++i) {
+        const sprite_span_t *sp = &s->spans[i];
+        int offset, skip;
+        int len = sprite_clip(sp, x, y, &offset, &skip);
+        if (len <= 0) continue;
+        volatile unsigned char *d = vram + offset;
+        const unsigned char *src = s->pixels + sp->pix + skip;
+        unsigned char *save = p->save + sp->pix + skip;
+        for (int k = 0; k < len; ++k) {
+            save[k] = d[k];
+            d[k] = src[k];
+        }
+    }
+}
+
+void sprite_erase(sprite_place_t *p) {
+    const sprite_t *s = p->sprite;
+    if (!s) return;
+    for (int i = 0; i < s->n_spans; ++i) {
+        const sprite_span_t *sp = &s->spans[i];
+        int offset, skip;
+        int len = sprite_clip(sp, p->x, p->y, &offset, &skip);
+        if (len <= 0) continue;
+        volatile unsigned char *d = p->vram + offset;
+        const unsigned char *save = p->save + sp->pix + skip;
+        for (int k = 0; k < len; ++k)
+            d[k] = save[k];
+    }
+    p->sprite = 0;
+}
+
+void sprite_forget(sprite_place_t *p) {
+    p->sprite = 0;
+}
+
+void sprite_erase_all(sprite_place_t *places, int n) {
+    for (int i = n - 1; i >= 0; --i)
+        sprite_erase(&places[i]);
+}
@@ -0,0 +1,44 @@
+// sprite.h
+
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include "vga.h"
+
+// Sprites are compiled once into the horizontal runs of their opaque pixels, so drawing
+// copies whole runs and never tests a pixel for transparency (colour 0).
+#define SPRITE_MAX_SPANS   64
+#define SPRITE_MAX_PIXELS  400
+
+typedef struct {
+    short dx, dy;   // start of the run inside the sprite
+    short len;      // pixels
+    short pix;      // index of its first pixel in pixels[] (and in a placement's save[])
+} sprite_span_t;
+
+typedef struct {
+    int n_spans;
+    sprite_span_t spans[SPRITE_MAX_SPANS];
+    unsigned char pixels[SPRITE_MAX_PIXELS];
+} sprite_t;
+
+// One sprite drawn into one buffer, with the pixels it covered (save-under).
+// Erasing puts exactly those back, so the screen behind it is never needed.
+typedef struct {
+    const sprite_t *sprite;         // 0 while not drawn
+    volatile unsigned char *vram;
+    int x, y;
+    unsigned char save[SPRITE_MAX_PIXELS];
+} sprite_place_t;
+
+// Compile a w x h sprite (row stride in bytes); -1 if it has too many runs or pixels
+int sprite_compile(sprite_t *s, const unsigned char *pixels, int w, int h, int stride);
+
+void sprite_draw(sprite_place_t *p, const sprite_t *s, volatile unsigned char *vram, int x, int y);
+void sprite_erase(sprite_place_t *p);
+void sprite_forget(sprite_place_t *p);   // the buffer was redrawn underneath, nothing to erase
+
+// Several sprites in one buffer: erase in reverse drawing order so overlaps restore correctly
+void sprite_erase_all(sprite_place_t *places, int n);
+
+#endif // SPRITE_H
@@ -6,6 +6,8 @@
 #include "image_processing.h"
 #include "background.h"
 #include "performance_analysis.h"
+#include "sprite.h"
+#include "blit.h"
 
 
 /* Hardware register addresses */
@@ -26,6 +28,15 @@ extern void delay(int ms);         // from timetemplate.S
 
 /* Local state */
 static unsigned char current_image[RES_Y][RES_X]; // working buffer for current image
+static ip_planar_t current_planes[2];  // planar copy of the current image + scratch for the next result
+static int planes_cur = 0;             // which of current_planes holds the current image
+static int planes_valid = 0;           // current_planes[planes_cur] matches the current image
+static int packed_valid = 1;           // current_image matches the current image
+static ip_integral_t current_integral;  // luma integral image of current_image, built on demand
+static int integral_valid = 0;         // current_integral matches current_image
+static unsigned char usm_blurred[2][RES_Y][RES_X];  // rotating blurred copies for the unsharp mask
+static int usm_radius[2] = { 0, 0 };   // radius each copy was blurred with, 0 = stale
+static int usm_next = 0;               // copy to replace next
 static bg_id_t current_bg = BG_MAIN; // current background/menu
 static int arrow_idx = 0; // current arrow index in menu
 static int selected_image_index; // 1,2,3 for Bliss,KTH,Icecream
@@ -44,42 +55,95 @@ static inline unsigned char clamp255(int v) {
     return (unsigned char)v;
 }
 
-static void draw_bg_to_vram(const unsigned char bg[RES_Y][RES_X], volatile unsigned char *vram) {
-    for (int y = 0; y < RES_Y; ++y)
-        for (int x = 0; x < RES_X; ++x)
-            vram[y * RES_X + x] = bg[y][x];
+/* Arrow cursor, compiled from handSprite at boot */
+static sprite_t hand_sprite;
+
+/* Menu backgrounds, compressed, indexed by bg_id_t */
+#define MENU_COUNT 3
+static const asset_t * const menu_assets[MENU_COUNT] = {
+    &asset_main_menu, &asset_upload_menu, &asset_process_menu
+};
+
+/* Difference spans between each pair of menus, streamed out of the compressed menus once
+ * at boot. Switching a buffer from one menu to another only writes the pixels that
+ * differ; a pair that does not fit in what is left of the pools (-1) is decoded in full.
+ */
+#define MENU_DIFF_MAX_SPANS  1024
+#define MENU_DIFF_MAX_PIXELS 24576
+static vga_span_t menu_spans[MENU_DIFF_MAX_SPANS];
+static unsigned char menu_pixels[2][MENU_DIFF_MAX_PIXELS];
+static vga_diff_t menu_diffs[MENU_COUNT];
+
+// Pair index of two different menus: main-upload 0, main-process 1, upload-process 2
+static int menu_pair(bg_id_t a, bg_id_t b) {
+    return a + b - 1;
 }
 
-static void show_background_now(const unsigned char bg[RES_Y][RES_X]) {
-    draw_bg_to_vram(bg, BUF0);
-    draw_bg_to_vram(bg, BUF1);
-    *(VGA_CTRL_PTR + 1) = (unsigned int) BUF0;
-    *(VGA_CTRL_PTR + 0) = 0;
-}
-
-static void draw_arrow_on_vram(volatile unsigned char *vram, int sx, int sy) {
-    for (int ry = 0; ry < 20; ++ry) {
-        int y = sy + ry;
-        if (y < 0 || y >= RES_Y) continue;
-        for (int rx = 0; rx < 20; ++rx) {
-            int x = sx + rx;
-            if (x < 0 || x >= RES_X) continue;
-            unsigned char s = handSprite[ry][rx];
-            if (s != 0) vram[y * RES_X + x] = s;
+static void build_menu_diffs(void) {
+    int spans = 0;
+    unsigned int pixels = 0;
+    for (int a = 0; a < MENU_COUNT; ++a) {
+        for (int b = a + 1; b < MENU_COUNT; ++b) {
+            vga_diff_t *d = &menu_diffs[menu_pair(a, b)];
+            vga_diff_init(d, menu_spans + spans, MENU_DIFF_MAX_SPANS - spans,
+                          menu_pixels[0] + pixels, menu_pixels[1] + pixels,
+                          MENU_DIFF_MAX_PIXELS - pixels);
+            if (asset_diff(d, menu_assets[a], menu_assets[b]) < 0) continue;
+            spans += d->n_spans;
+            pixels += d->n_pix;
         }
     }
 }
 
-static void restore_region_from_bg(volatile unsigned char *vram, const unsigned char bg[RES_Y][RES_X], int sx, int sy) {
-    for (int ry = 0; ry < 20; ++ry) {
-        int y = sy + ry;
-        if (y < 0 || y >= RES_Y) continue;
-        for (int rx = 0; rx < 20; ++rx) {
-            int x = sx + rx;
-            if (x < 0 || x >= RES_X) continue;
-            vram[y * RES_X + x] = bg[y][x];
+/* What each of the two VGA buffers currently holds.
+ * Frames are only drawn into the back buffer (see vga_present), so each buffer is
+ * brought up to date on its own, with only the parts that differ from what it holds.
+ */
+typedef struct {
+    int menu;               // bg_id_t of the menu in it, -1 for an image
+    sprite_place_t arrow;   // its arrow and the menu pixels under it
+} vram_state_t;
+
+static vram_state_t vram_state[2] = { { -1 }, { -1 } };
+
+static vram_state_t *vram_state_of(volatile unsigned char *vram) {
+    return &vram_state[vram == BUF1];
+}
+
+/* Show a menu with the arrow at (ax, ay) */
+static void present_menu(bg_id_t menu, int ax, int ay) {
+    volatile unsigned char *vram = vga_back_buffer();
+    vram_state_t *st = vram_state_of(vram);
+    if (st->menu != (int)menu) {
+#ifdef RUN_PERFORMANCE_TESTS
+        before_perf();
+#endif
+        const vga_diff_t *d = (st->menu >= 0) ? &menu_diffs[menu_pair(st->menu, menu)] : 0;
+        if (d && d->n_spans >= 0) {
+            // Take the old arrow off first so the buffer holds exactly the old menu
+            sprite_erase(&st->arrow);
+            vga_diff_apply(d, (int)menu > st->menu, vram);
+        } else {
+            asset_decode(menu_assets[menu], vram);
+            sprite_forget(&st->arrow);
         }
+#ifdef RUN_PERFORMANCE_TESTS
+        present_data("Menu transition");
+#endif
+        st->menu = menu;
+    } else {
+        sprite_erase(&st->arrow);
     }
+    sprite_draw(&st->arrow, &hand_sprite, vram, ax, ay);
+    vga_present();
+}
+
+/* Present a frame that was drawn into the back buffer and is not a menu */
+static void present_frame(volatile unsigned char *vram) {
+    vram_state_t *st = vram_state_of(vram);
+    st->menu = -1;
+    sprite_forget(&st->arrow);
+    vga_present();
 }
 
 /* pixel positions */
@@ -107,141 +171,466 @@ static int process_option_x(int idx) {
 static int main_option_x(int idx)    { return 40; } // Always left-aligned
 
 
+/* Drop everything derived from the current image's pixels */
+static void image_changed(void) {
+    integral_valid = 0;
+    usm_radius[0] = usm_radius[1] = 0;
+}
+
+/* The photos are decoded straight into current_image when uploaded. A download keeps
+ * the result in the image's slot, which replaces the photo from then on. */
+#define IMAGE_COUNT 3
+static const asset_t * const image_assets[IMAGE_COUNT] = {
+    &asset_bliss, &asset_kth, &asset_icecream
+};
+static unsigned char saved_images[IMAGE_COUNT][RES_Y][RES_X];
+static int image_saved[IMAGE_COUNT];
+
 /* load selected image into working buffer */
 static void load_selected_image(void) {
-    unsigned char (*src)[RES_X] = ( (void*)0 ); // ( (void*)0 ) is NULL pointer
-    switch (selected_image_index) {
-        case 1: src = (unsigned char (*)[RES_X])Bliss; break;
-        case 2: src = (unsigned char (*)[RES_X])KTH; break;
-        case 3: src = (unsigned char (*)[RES_X])Icecream; break;
-    }
-    if (src) {
-        for (int y=0;y<RES_Y;y++)
-            for (int x=0;x<RES_X;x++)
-                current_image[y][x] = src[y][x];
+    int i = selected_image_index - 1;
+    if (i >= 0 && i < IMAGE_COUNT) {
+        if (image_saved[i])
+            blit_frame(current_image, saved_images[i]);
+        else
+            asset_decode(image_assets[i], (volatile unsigned char *)current_image);
+        // Decode once per loaded image; planar filters keep the planes up to date after that
+        ip_to_planar(current_image, &current_planes[planes_cur]);
+        planes_valid = 1;
+        packed_valid = 1;
+        image_changed();
     }
 }
 
 static void draw_current_image_to_vram(volatile unsigned char *vram) {
-    for (int y=0;y<RES_Y;y++)
-        for (int x=0;x<RES_X;x++)
-            vram[y*RES_X + x] = current_image[y][x];
+    blit_frame(vram, current_image);
 }
 
 static void copy_current_to_imageN(void) {
-    unsigned char (*dst)[RES_X] = ( (void*)0 ); // ( (void*)0 ) is NULL pointer
-    switch (selected_image_index) {
-        case 1: dst = (unsigned char (*)[RES_X])Bliss; break;
-        case 2: dst = (unsigned char (*)[RES_X])KTH; break;
-        case 3: dst = (unsigned char (*)[RES_X])Icecream; break;
-    }
-    if (dst) {
-        for (int y=0;y<RES_Y;y++)
-            for (int x=0;x<RES_X;x++)
-                dst[y][x] = current_image[y][x];
+    int i = selected_image_index - 1;
+    if (i >= 0 && i < IMAGE_COUNT) {
+        blit_frame(saved_images[i], current_image);
+        image_saved[i] = 1;
     }
 }
 
 static void render_current_menu(void) {
     switch (current_bg) {
         case BG_MAIN:
-            show_background_now(mainMenuStyle);
-            draw_arrow_on_vram(BUF0, main_option_x(arrow_idx), main_option_y(arrow_idx));
+            present_menu(BG_MAIN, main_option_x(arrow_idx), main_option_y(arrow_idx));
             break;
         case BG_UPLOAD:
-            show_background_now(uploadMenuStyle);
-            draw_arrow_on_vram(BUF0, upload_option_x(arrow_idx), upload_option_y(arrow_idx));
+            present_menu(BG_UPLOAD, upload_option_x(arrow_idx), upload_option_y(arrow_idx));
             break;
         case BG_PROCESS:
-            show_background_now(processMenuStyle);
-            draw_arrow_on_vram(BUF0, process_option_x(arrow_idx), process_option_y(arrow_idx));
+            present_menu(BG_PROCESS, process_option_x(arrow_idx), process_option_y(arrow_idx));
             break;
     }
 }
-/*
-// With performance analysis
-static void apply_process_and_show(int option_idx) {
-    const char* filter_names[] = {
-        "Grayscale", "Black & White", "Invert", "Mirror", 
-        "Blur 3x3", "Sharpen 3x3", "Sobel"
-    };
-    
-    // Only run performance analysis if we have a valid filter
-    if (option_idx >= 0 && option_idx <= 6) {
-        before_perf();
+/* ---- process menu ----
+ * The process menu art shows PROCESS_ROWS filter rows. Switches SW1-SW3 select which
+ * page of filters those rows map to; page 0 is the set printed on the menu art, the
+ * other pages are listed over the JTAG UART when the process menu is opened.
+ * Most entries are a short list of fused-chain stages (see ip_run_chain), so an entry
+ * may also be a preset chain that runs in a single sweep. Filters that cannot be streamed
+ * through the chain are plain whole-frame functions ('apply'), optionally taking a
+ * radius read from switches SW4-SW7 ('apply_r', radius 0 reads as 1). Adaptive
+ * threshold entries ('adaptive') run off the cached integral image of the current image.
+ * Statistics entries ('table') build a remap table from the image histogram and are
+ * then applied like any other point filter. Blob entries ('blobs') only inspect the
+ * current image: they print connected components over the JTAG UART and show them.
+ * The unsharp mask ('unsharp') takes its radius from SW4-SW7 and its amount from SW8-SW9.
+ */
+#define PROCESS_ROWS 7
+#define PROCESS_PAGES 7
+#define PROCESS_MAX_STAGES 3
+
+typedef struct {
+    const char *name;
+    int n_stages;
+    ip_stage_t stages[PROCESS_MAX_STAGES];
+    // Optional planar version of a single 3x3 stage, used on the cached planes
+    void (*planar)(const ip_planar_t *src, volatile unsigned char *dst, ip_planar_t *out);
+    // Whole-frame filter, used when n_stages is 0
+    void (*apply)(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst);
+    // Whole-frame filter with a radius, used when n_stages is 0 and apply is not set
+    void (*apply_r)(const unsigned char src[RES_Y][RES_X], volatile unsigned char *dst, int radius);
+    // Integral-image threshold, radius 2 * SW4-SW7
+    void (*adaptive)(const ip_integral_t *ii, const unsigned char src[RES_Y][RES_X],
+                     volatile unsigned char *dst, int radius, int percent);
+    // Remap table built from the image statistics
+    void (*table)(const ip_stats_t *st, unsigned char lut[256]);
+    // Connected-component report: BLOBS_MASK shows the mask, BLOBS_BOXES boxes on the image
+    int blobs;
+    // Unsharp mask applied against a cached blurred copy
+    void (*unsharp)(const unsigned char src[RES_Y][RES_X], const unsigned char blurred[RES_Y][RES_X],
+                    volatile unsigned char *dst, int amount);
+} process_entry_t;
+
+#define BLOBS_MASK  1
+#define BLOBS_BOXES 2
+
+#define FRAME(fn)    0, { { 0, 0 } }, 0, fn
+#define FRAME_R(fn)  0, { { 0, 0 } }, 0, 0, fn
+#define FRAME_II(fn) 0, { { 0, 0 } }, 0, 0, 0, fn
+#define STATS(fn)    0, { { 0, 0 } }, 0, 0, 0, 0, fn
+#define BLOBS(mode)  0, { { 0, 0 } }, 0, 0, 0, 0, 0, mode
+#define UNSHARP(fn)  0, { { 0, 0 } }, 0, 0, 0, 0, 0, 0, fn
+
+#define POINT(lut)   { IP_STAGE_LUT, lut }
+#define STAGE(kind)  { kind, 0 }
+
+static const process_entry_t process_pages[PROCESS_PAGES][PROCESS_ROWS] = {
+    {
+        { "Grayscale",     1, { POINT(ip_lut_grayscale) } },
+        { "Black & White", 1, { POINT(ip_lut_blackwhite) } },
+        { "Invert",        1, { POINT(ip_lut_invert) } },
+        { "Mirror",        1, { STAGE(IP_STAGE_MIRROR) } },
+        { "Blur 3x3",      1, { STAGE(IP_STAGE_BLUR) },    ip_blur3x3_planar },
+        { "Sharpen 3x3",   1, { STAGE(IP_STAGE_SHARPEN) }, ip_sharpen3x3_planar },
+        { "Sobel",         1, { STAGE(IP_STAGE_SOBEL) },   ip_sobel_planar },
+    },
+    {
+        { "Sepia",         1, { POINT(ip_lut_sepia) } },
+        { "Posterize",     1, { POINT(ip_lut_posterize) } },
+        { "Red only",      1, { POINT(ip_lut_red_only) } },
+        { "Green only",    1, { POINT(ip_lut_green_only) } },
+        { "Blue only",     1, { POINT(ip_lut_blue_only) } },
+        { "Gamma 0.5",     1, { POINT(ip_lut_gamma) } },
+        { "Blur+Sharpen+Sobel", 3, { STAGE(IP_STAGE_BLUR), STAGE(IP_STAGE_SHARPEN), STAGE(IP_STAGE_SOBEL) } },
+    },
+    {
+        { "Gaussian 3x3",     FRAME(ip_gaussian3x3) },
+        { "Gaussian 5x5",     FRAME(ip_gaussian5x5) },
+        { "Box 5x5",          FRAME(ip_box5x5) },
+        { "Emboss",           FRAME(ip_emboss) },
+        { "Laplacian",        FRAME(ip_laplacian) },
+        { "Edge enhance",     FRAME(ip_edge_enhance) },
+        { "Sharpen (engine)", FRAME(ip_sharpen3x3_engine) },
+    },
+    {
+        { "Median 3x3",       FRAME(ip_median3x3) },
+        { "Median 5x5",       FRAME(ip_median5x5) },
+        { "Box blur (r)",     FRAME_R(ip_box_blur) },
+        { "Gaussian (r)",     FRAME_R(ip_gaussian_approx) },
+        { "Adaptive B&W (r)", FRAME_II(ip_adaptive_threshold) },
+    },
+    {
+        { "Auto levels",      STATS(ip_autolevels_table) },
+        { "Equalize",         STATS(ip_equalize_table) },
+        { "Otsu B&W",         STATS(ip_otsu_table) },
+        { "CLAHE",            FRAME(ip_clahe) },
+        { "Gray (dithered)",  FRAME(ip_dither_fs_gray) },
+        { "B&W (dithered)",   FRAME(ip_dither_fs_bw) },
+        { "B&W (ordered)",    FRAME(ip_dither_ordered_bw) },
+    },
+    {
+        { "Erode (r)",        FRAME_R(ip_erode) },
+        { "Dilate (r)",       FRAME_R(ip_dilate) },
+        { "Open (r)",         FRAME_R(ip_open) },
+        { "Close (r)",        FRAME_R(ip_close) },
+        { "Label blobs",      BLOBS(BLOBS_MASK) },
+        { "Blob boxes",       BLOBS(BLOBS_BOXES) },
+        { "Distance glow",    FRAME(ip_distance) },
+    },
+    {
+        { "Canny edges",      FRAME(ip_canny) },
+        { "Bilateral (r)",    FRAME_R(ip_bilateral) },
+        { "Unsharp (r, amt)", UNSHARP(ip_unsharp_apply) },
+    },
+};
+
+/* Pending point-filter table.
+ * While only point filters are stacked, current_image keeps the image from before the
+ * first of them and pending_lut holds their composition. The next point filter composes
+ * into the table and is applied from current_image in one pass, with no copy-back.
+ * Any other entry runs the pending table as the first stage of its chain.
+ */
+static unsigned char pending_lut[256];
+static int lut_pending = 0;
+
+// Back buffer the filter being applied renders into
+static volatile unsigned char *frame;
+
+static const unsigned char *pending_table(void) {
+    return pending_lut;
+}
+
+static int process_page(void) {
+    int page = ((*SW_BASE) >> 1) & 0x7;
+    return (page < PROCESS_PAGES) ? page : 0;
+}
+
+static int process_radius(void) {
+    int radius = ((*SW_BASE) >> 4) & 0xF;
+    return radius ? radius : 1;
+}
+
+// Unsharp amount in quarters: SW8-SW9 select 0.5, 1.0, 1.5 or 2.0
+static int process_amount(void) {
+    return (((*SW_BASE) >> 8) & 0x3) * 2 + 2;
+}
+
+static void print_process_page(void) {
+    int page = process_page();
+    print("\nProcess menu page "); print_dec(page); print(" (SW1-SW3):\n");
+    for (int i = 0; i < PROCESS_ROWS; ++i) {
+        if (!process_pages[page][i].name) continue;
+        print("  "); print_dec(i + 1); print(". ");
+        print(process_pages[page][i].name);
+        if (process_pages[page][i].apply_r) {
+            print(", r = "); print_dec(process_radius()); print(" (SW4-SW7)");
+        } else if (process_pages[page][i].adaptive) {
+            print(", r = "); print_dec(2 * process_radius()); print(" (2 x SW4-SW7)");
+        } else if (process_pages[page][i].unsharp) {
+            print(", r = "); print_dec(process_radius()); print(" (SW4-SW7), amount = ");
+            print_dec(process_amount()); print("/4 (SW8-SW9)");
+        }
+        printc('\n');
     }
-    
-    // Apply the filter
-    switch (option_idx) {
-        case 0: ip_grayscale(current_image, BUF0); break;
-        case 1: ip_blackwhite(current_image, BUF0); break;
-        case 2: ip_invert(current_image, BUF0); break;
-        case 3: ip_mirror(current_image, BUF0); break;
-        case 4: ip_blur3x3(current_image, BUF0); break;
-        case 5: ip_sharpen3x3(current_image, BUF0); break;
-        case 6: ip_sobel(current_image, BUF0); break;
-        default: return;
+}
+
+/* The current image lives in current_image (packed) and/or current_planes (planar).
+ * Planar filters only update the planes, everything else only current_image;
+ * each representation is re-derived from the other only when it is stale.
+ */
+static void sync_packed(void) {
+    if (packed_valid) return;
+    ip_from_planar(&current_planes[planes_cur], (volatile unsigned char *)current_image);
+    packed_valid = 1;
+}
+
+static void sync_planes(void) {
+    if (planes_valid) return;
+    ip_to_planar(current_image, &current_planes[planes_cur]);
+    planes_valid = 1;
+}
+
+/* Bring current_image up to date and bake any pending point-filter table into it */
+static void flush_pending_lut(void) {
+    sync_packed();
+    if (!lut_pending) return;
+    ip_apply_lut(current_image, (volatile unsigned char *)current_image, pending_lut);
+    lut_pending = 0;
+    planes_valid = 0;
+    image_changed();
+}
+
+static void apply_point_filter(const unsigned char *lut) {
+    sync_packed();
+    if (lut_pending) {
+        unsigned char composed[256];
+        ip_compose_lut(pending_lut, lut, composed);
+        for (int i = 0; i < 256; ++i) pending_lut[i] = composed[i];
+    } else {
+        for (int i = 0; i < 256; ++i) pending_lut[i] = lut[i];
+        lut_pending = 1;
     }
-    
-    // Display the result
-    *(VGA_CTRL_PTR + 1) = (unsigned int)BUF0;
-    *(VGA_CTRL_PTR + 0) = 0;
-    
-    // Copy back into current_image for filter stacking
-    for (int y=0;y<RES_Y;y++) {
-        for (int x=0;x<RES_X;x++) {
-            current_image[y][x] = BUF0[y*RES_X + x];
-        }
+    ip_apply_lut(current_image, frame, pending_lut);
+}
+
+/* Run the entry's stages (after any pending table) in one sweep.
+ * The result goes to the frame and back into current_image for filter stacking,
+ * without re-reading the framebuffer.
+ */
+static void apply_chain(const process_entry_t *e) {
+    ip_stage_t chain[IP_CHAIN_MAX];
+    int n = 0;
+    sync_packed();
+    if (lut_pending) {
+        chain[n].kind = IP_STAGE_LUT;
+        chain[n].lut = pending_table;
+        n++;
     }
-    
-    // Run performance analysis after filter application
-    if (option_idx >= 0 && option_idx <= 6) {
-        present_data(filter_names[option_idx]);
+    for (int i = 0; i < e->n_stages; ++i)
+        chain[n++] = e->stages[i];
+    ip_run_chain(chain, n, current_image, frame, current_image);
+    lut_pending = 0;
+    planes_valid = 0;
+    image_changed();
+}
+
+/* Run a whole-frame filter into the frame and copy the result back for filter stacking */
+static void apply_frame(const process_entry_t *e) {
+    flush_pending_lut();
+    if (e->apply)
+        e->apply(current_image, frame);
+    else
+        e->apply_r(current_image, frame, process_radius());
+    blit_frame(current_image, frame);
+    planes_valid = 0;
+    image_changed();
+}
+
+/* Run a planar filter on the cached planes; the result planes become the current ones */
+static void apply_planar(const process_entry_t *e) {
+    sync_planes();
+    e->planar(&current_planes[planes_cur], frame, &current_planes[planes_cur ^ 1]);
+    planes_cur ^= 1;
+    packed_valid = 0;
+    image_changed();
+}
+
+/* Adaptive threshold, left pending like a point filter.
+ * current_image keeps the image being thresholded, so applying the threshold again with
+ * another radius replaces the previous result and only costs the final pass over the
+ * cached integral image. Any other entry (or a download) bakes it in first.
+ */
+static int threshold_pending = 0;
+static int threshold_radius;
+
+static void flush_pending_threshold(void) {
+    if (!threshold_pending) return;
+    ip_adaptive_threshold(&current_integral, current_image, (volatile unsigned char *)current_image,
+                          threshold_radius, IP_ADAPTIVE_PERCENT);
+    threshold_pending = 0;
+    planes_valid = 0;
+    image_changed();
+}
+
+static void apply_adaptive(const process_entry_t *e) {
+    flush_pending_lut();
+    if (!integral_valid) {
+        ip_integral_build(current_image, &current_integral);
+        integral_valid = 1;
     }
+    threshold_radius = 2 * process_radius();
+    e->adaptive(&current_integral, current_image, frame, threshold_radius, IP_ADAPTIVE_PERCENT);
+    threshold_pending = 1;
+}
+
+/* Unsharp mask, left pending like the adaptive threshold.
+ * The blurred copy of the current image is kept in one of two rotating buffers, tagged
+ * with its radius. Re-applying with another amount (or going back to the previous
+ * radius) reuses it, so only the table pass runs; a new radius replaces the older copy.
+ */
+static int unsharp_pending = 0;
+static int unsharp_slot, unsharp_amount;
+
+static void flush_pending_unsharp(void) {
+    if (!unsharp_pending) return;
+    ip_unsharp_apply(current_image, usm_blurred[unsharp_slot], (volatile unsigned char *)current_image,
+                     unsharp_amount);
+    unsharp_pending = 0;
+    planes_valid = 0;
+    image_changed();
 }
-*/
 
-// Normal version without performance analysis
-static void apply_process_and_show(int option_idx) {
-    switch (option_idx) {
-        case 0: ip_grayscale(current_image, BUF0); break;
-        case 1: ip_blackwhite(current_image, BUF0); break;
-        case 2: ip_invert(current_image, BUF0); break;
-        case 3: ip_mirror(current_image, BUF0); break;
-        case 4: ip_blur3x3(current_image, BUF0); break;
-        case 5: ip_sharpen3x3(current_image, BUF0); break;
-        case 6: ip_sobel(current_image, BUF0); break;
-        default: return;
+static void apply_unsharp(const process_entry_t *e) {
+    const int radius = process_radius();
+    flush_pending_lut();
+    if (usm_radius[0] == radius) {
+        unsharp_slot = 0;
+    } else if (usm_radius[1] == radius) {
+        unsharp_slot = 1;
+    } else {
+        unsharp_slot = usm_next;
+        usm_next ^= 1;
+        ip_box_blur(current_image, (volatile unsigned char *)usm_blurred[unsharp_slot], radius);
+        usm_radius[unsharp_slot] = radius;
     }
-    *(VGA_CTRL_PTR + 1) = (unsigned int) BUF0;
-    *(VGA_CTRL_PTR + 0) = 0;
+    unsharp_amount = process_amount();
+    e->unsharp(current_image, usm_blurred[unsharp_slot], frame, unsharp_amount);
+    unsharp_pending = 1;
+}
+
+/* Gather statistics of the current image, then apply the table built from them as a
+ * point filter (so it stays pending and composes with the next point filter) */
+static void apply_stats(const process_entry_t *e) {
+    static ip_stats_t st;
+    unsigned char lut[256];
+    flush_pending_lut();
+    ip_stats(current_image, &st);
+    e->table(&st, lut);
+    apply_point_filter(lut);
 }
 
+/* Label the white (>= 128) pixels of the current image and report the components.
+ * The current image is left as it is; only the display shows the mask or the boxes.
+ */
+#define BLOB_MIN_AREA   16   // smaller components are counted but not listed or boxed
+#define BLOB_MAX_LISTED 32
 
-/* Only updates arrow, not entire screen */
+static ip_binary_t blob_mask;
+
+static void print_blobs(const ip_ccl_t *ccl) {
+    int listed = 0;
+    print("Blobs: "); print_dec(ccl->n_blobs);
+    print(" ("); print_dec(ccl->n_runs); print(" runs)\n");
+    if (ccl->n_dropped) {
+        print("  "); print_dec(ccl->n_dropped); print(" more not stored\n");
+    }
+    for (int i = 0; i < ccl->n_blobs && listed < BLOB_MAX_LISTED; ++i) {
+        const ip_blob_t *b = &ccl->blobs[i];
+        if (b->area < BLOB_MIN_AREA) continue;
+        listed++;
+        print("  #"); print_dec(i);
+        print(" area "); print_dec(b->area);
+        print(" box ("); print_dec(b->x0); printc(','); print_dec(b->y0);
+        print(")-("); print_dec(b->x1); printc(','); print_dec(b->y1); print(")\n");
+    }
+}
+
+static void apply_blobs(const process_entry_t *e) {
+    flush_pending_lut();
+    ip_to_binary(current_image, &blob_mask);
+    const ip_ccl_t *labels = ip_label(&blob_mask);
+    print_blobs(labels);
+    if (e->blobs == BLOBS_BOXES) {
+        draw_current_image_to_vram(frame);
+        ip_draw_blobs(labels, frame, BLOB_MIN_AREA);
+    } else {
+        ip_from_binary(&blob_mask, frame);
+    }
+}
+
+/* Returns 1 if a processed frame is on screen, 0 for an empty row (nothing shown,
+ * the menu stays up) */
+static int apply_process_and_show(int option_idx) {
+    const process_entry_t *e = &process_pages[process_page()][option_idx];
+    if (e->n_stages == 0 && !e->apply && !e->apply_r && !e->adaptive && !e->table && !e->blobs && !e->unsharp)
+        return 0;
+    if (!e->adaptive)
+        flush_pending_threshold();
+    if (!e->unsharp)
+        flush_pending_unsharp();
+    frame = vga_back_buffer();
+
+#ifdef RUN_PERFORMANCE_TESTS
+    before_perf();
+#endif
+
+    if (e->adaptive)
+        apply_adaptive(e);
+    else if (e->table)
+        apply_stats(e);
+    else if (e->blobs)
+        apply_blobs(e);
+    else if (e->unsharp)
+        apply_unsharp(e);
+    else if (e->n_stages == 0)
+        apply_frame(e);
+    else if (e->n_stages == 1 && e->stages[0].kind == IP_STAGE_LUT)
+        apply_point_filter(e->stages[0].lut());
+    else if (e->planar && !lut_pending)
+        apply_planar(e);
+    else
+        apply_chain(e);
+
+#ifdef RUN_PERFORMANCE_TESTS
+    present_data(e->name);
+#endif
+
+    present_frame(frame);
+    return 1;
+}
+
+
+/* Only updates arrow, not entire screen: the back buffer already holds this menu,
+ * so present_menu only erases the arrow from its save-under and draws it again */
 static void update_arrow_position(int new_idx) {
-    int old_idx = arrow_idx;
     arrow_idx = new_idx;
-    
-    // Only redraw the pixels that changed
-    switch (current_bg) {
-        case BG_MAIN:
-            restore_region_from_bg(BUF0, mainMenuStyle, main_option_x(old_idx), main_option_y(old_idx));
-            draw_arrow_on_vram(BUF0, main_option_x(arrow_idx), main_option_y(arrow_idx));
-            break;
-        case BG_UPLOAD:
-            restore_region_from_bg(BUF0, uploadMenuStyle, upload_option_x(old_idx), upload_option_y(old_idx));
-            draw_arrow_on_vram(BUF0, upload_option_x(arrow_idx), upload_option_y(arrow_idx));
-            break;
-        case BG_PROCESS:
-            restore_region_from_bg(BUF0, processMenuStyle, process_option_x(old_idx), process_option_y(old_idx));
-            draw_arrow_on_vram(BUF0, process_option_x(arrow_idx), process_option_y(arrow_idx));
-            break;
-    }
-    
-    // Single buffer swap
-    *(VGA_CTRL_PTR + 1) = (unsigned int)BUF0;
-    *(VGA_CTRL_PTR + 0) = 0;
+    render_current_menu();
 }
 
 /* Get maximum index for current background */
@@ -249,7 +638,7 @@ static int get_max_index(void) {
     switch (current_bg) {
         case BG_MAIN: return 2;
         case BG_UPLOAD: return 3; 
-        case BG_PROCESS: return 7;
+        case BG_PROCESS: return PROCESS_ROWS;
         default: return 0;
     }
 }
@@ -334,18 +723,25 @@ void process_ui_events(void) {
                     current_bg = BG_PROCESS;
                     arrow_idx = 0; 
                     render_current_menu();
+                    print_process_page();
                     break;
                 case 2: // Download
+                    flush_pending_threshold();
+                    flush_pending_unsharp();
+                    flush_pending_lut();
                     copy_current_to_imageN();
-                    draw_current_image_to_vram(BUF0);
-                    *(VGA_CTRL_PTR + 1) = (unsigned int)BUF0;
-                    *(VGA_CTRL_PTR + 0) = 0;
+                    frame = vga_back_buffer();
+                    draw_current_image_to_vram(frame);
+                    present_frame(frame);
                     current_state = STATE_VIEWING_IMAGE;
                     break;
             }
         } else if (current_bg == BG_UPLOAD) {
             if (arrow_idx >= 0 && arrow_idx <= 2) {
                 selected_image_index = arrow_idx + 1;
+                lut_pending = 0;
+                threshold_pending = 0;
+                unsharp_pending = 0;
                 load_selected_image();
                 current_bg = BG_MAIN;
                 arrow_idx = 0;
@@ -356,16 +752,10 @@ void process_ui_events(void) {
                 render_current_menu();
             }
         } else if (current_bg == BG_PROCESS) {
-            if (arrow_idx >= 0 && arrow_idx <= 6) {
-                apply_process_and_show(arrow_idx);
-                // Copy result back for filter stacking
-                for (int y=0;y<RES_Y;y++) {
-                    for (int x=0;x<RES_X;x++) {
-                        current_image[y][x] = BUF0[y*RES_X + x];
-                    }
-                }
-                current_state = STATE_VIEWING_IMAGE;
-            } else if (arrow_idx == 7) { // Return
+            if (arrow_idx >= 0 && arrow_idx < PROCESS_ROWS) {
+                if (apply_process_and_show(arrow_idx))
+                    current_state = STATE_VIEWING_IMAGE;
+            } else if (arrow_idx == PROCESS_ROWS) { // Return
                 current_bg = BG_MAIN;
                 arrow_idx = 0;
                 render_current_menu();
@@ -376,5 +766,8 @@ void process_ui_events(void) {
 
 /* public helper */
 void ui_draw_initial(void) {
+    sprite_compile(&hand_sprite, &handSprite[0][0], 20, 20, 20);
     render_current_menu();
+    // After the first frame: nothing needs the spans until the first menu change
+    build_menu_diffs();
 }
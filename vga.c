@@ -2,35 +2,129 @@
 
 #include "vga.h"
 #include "background.h"
+#include "blit.h"
 
 volatile unsigned char * const BUF0 = (volatile unsigned char *) VGA_BASE;
 volatile unsigned char * const BUF1 = (volatile unsigned char *) (VGA_BASE + RES_X * RES_Y);
 volatile unsigned int  * const VGA_CTRL_PTR = (volatile unsigned int *) VGA_CTRL;
 
+/* Frame presentation
+ * One buffer is scanned out (front), the other is rendered into (back). Writing the
+ * buffer register asks the DMA to swap to the back-buffer register's address at the
+ * next vertical blank; the status register's S bit stays set until it has. Until then
+ * the old front is still on screen, so handing it out as the next back buffer waits
+ * for the swap to land. Nothing is ever drawn into the visible buffer.
+ */
+static volatile unsigned char *vga_front;
+static volatile unsigned char *vga_back;
+static int vga_swap_pending = 0;
+static unsigned int vga_presented = 0;
+
+static void vga_poll(void) {
+    if (vga_swap_pending && !(VGA_CTRL_PTR[VGA_REG_STATUS] & VGA_STATUS_SWAP)) {
+        vga_swap_pending = 0;
+        vga_presented++;
+    }
+}
+
 void vga_init(void) {
-    *VGA_CTRL_PTR = 0x1; // Enable DMA
+    VGA_CTRL_PTR[VGA_REG_BACK] = (unsigned int) BUF0;
+    VGA_CTRL_PTR[VGA_REG_BUFFER] = 0x1; // Enable DMA, BUF0 to the front
+    while (VGA_CTRL_PTR[VGA_REG_STATUS] & VGA_STATUS_SWAP)
+        ;
+    vga_front = BUF0;
+    vga_back = BUF1;
+}
+
+volatile unsigned char *vga_back_buffer(void) {
+    vga_wait_presented();
+    return vga_back;
+}
+
+volatile unsigned char *vga_front_buffer(void) {
+    vga_wait_presented();
+    return vga_front;
+}
+
+void vga_present(void) {
+    vga_wait_presented();
+    VGA_CTRL_PTR[VGA_REG_BACK] = (unsigned int) vga_back;
+    VGA_CTRL_PTR[VGA_REG_BUFFER] = 0;   // swap at the next vertical blank
+    volatile unsigned char *shown = vga_back;
+    vga_back = vga_front;
+    vga_front = shown;
+    vga_swap_pending = 1;
+}
+
+int vga_present_pending(void) {
+    vga_poll();
+    return vga_swap_pending;
+}
+
+void vga_wait_presented(void) {
+    while (vga_swap_pending)
+        vga_poll();
+}
+
+unsigned int vga_frames_presented(void) {
+    vga_poll();
+    return vga_presented;
 }
 
 void vga_swap_buffers(void) {
-    *VGA_CTRL_PTR = 0x1; // Trigger swap
+    vga_present();
 }
 
-void draw_background(volatile unsigned char *vram) {
-    for (int y = 0; y < RES_Y; y++) {
-        for (int x = 0; x < RES_X; x++) {
-            vram[y * RES_X + x] = test1[y][x];
+/* Difference spans
+ * A span only ends after VGA_SPAN_GAP equal pixels, since a span costs more than a few
+ * extra stores. Spans stay within their row so they can be found a row at a time.
+ */
+void vga_diff_init(vga_diff_t *d, vga_span_t *spans, int max_spans,
+                   unsigned char *pix_a, unsigned char *pix_b, unsigned int max_pix) {
+    d->spans = spans;
+    d->n_spans = 0;
+    d->max_spans = max_spans;
+    d->pix[0] = pix_a;
+    d->pix[1] = pix_b;
+    d->n_pix = 0;
+    d->max_pix = max_pix;
+}
+
+void vga_diff_row(vga_diff_t *d, int y, const unsigned char *a, const unsigned char *b) {
+    int x = 0;
+    while (x < RES_X && d->n_spans >= 0) {
+        if (a[x] == b[x]) { x++; continue; }
+        int start = x, end = x + 1;   // end: one past the last differing pixel
+        for (x = end; x < RES_X && x - end < VGA_SPAN_GAP; x++)
+            if (a[x] != b[x]) end = x + 1;
+        unsigned int len = end - start;
+        if (d->n_spans == d->max_spans || d->n_pix + len > d->max_pix) {
+            d->n_spans = -1;
+            return;
         }
+        vga_span_t *sp = &d->spans[d->n_spans++];
+        sp->start = y * RES_X + start;
+        sp->len = len;
+        sp->pix = d->n_pix;
+        blit_copy(d->pix[0] + d->n_pix, a + start, len);
+        blit_copy(d->pix[1] + d->n_pix, b + start, len);
+        d->n_pix += len;
+        x = end;
     }
 }
 
+void vga_diff_apply(const vga_diff_t *d, int to_b, volatile unsigned char *vram) {
+    const unsigned char *pix = d->pix[to_b != 0];
+    for (int s = 0; s < d->n_spans; ++s)
+        blit_copy(vram + d->spans[s].start, pix + d->spans[s].pix, d->spans[s].len);
+}
+
+void draw_background(volatile unsigned char *vram) {
+    asset_decode(&asset_test1, vram);
+}
+
 void vga_show_background(void) {
-    draw_background(BUF0);
-    draw_background(BUF1);
-    *(VGA_CTRL_PTR + 1) = (unsigned int) BUF0;
-    *(VGA_CTRL_PTR + 0) = 0;
-
-    // little wait so the hardware settles
-    for (volatile int i = 0; i < 100000; i++) {
-        asm volatile ("nop");
-    }
-}
\ No newline at end of file
+    draw_background(vga_back_buffer());
+    vga_present();
+    vga_wait_presented();
+}
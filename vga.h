@@ -12,8 +12,47 @@ extern volatile unsigned char * const BUF0;
 extern volatile unsigned char * const BUF1;
 extern volatile unsigned int  * const VGA_CTRL_PTR;
 
+// Pixel buffer DMA registers (word offsets from VGA_CTRL)
+#define VGA_REG_BUFFER  0   // write: swap to the back buffer at the next vertical blank
+#define VGA_REG_BACK    1   // back buffer address
+#define VGA_REG_STATUS  3   // status, bit 0 (S) set while a swap is pending
+#define VGA_STATUS_SWAP 0x1
+
 void vga_init(void);
-void vga_swap_buffers(void);
+
+// Double-buffered presentation: render into vga_back_buffer(), then vga_present().
+// The flip lands on vertical blank; vga_frames_presented() counts completed flips.
+volatile unsigned char *vga_back_buffer(void);
+volatile unsigned char *vga_front_buffer(void);
+void vga_present(void);
+int vga_present_pending(void);
+void vga_wait_presented(void);
+unsigned int vga_frames_presented(void);
+
+// Difference spans between two full-screen images: the runs of pixels where they differ,
+// with the pixels of both images under them. Switching a buffer from one image to the
+// other only writes those runs, and neither image is needed in full. Built a row at a time.
+typedef struct {
+    unsigned int start;    // first pixel, y * RES_X + x
+    unsigned int len;      // pixels
+    unsigned int pix;      // index of its pixels in the pixel pools
+} vga_span_t;
+
+typedef struct {
+    vga_span_t *spans;
+    int n_spans, max_spans;        // n_spans is -1 once spans or pixels ran out
+    unsigned char *pix[2];         // pixels of image a and image b under the spans
+    unsigned int n_pix, max_pix;
+} vga_diff_t;
+
+#define VGA_SPAN_GAP 8     // runs of equal pixels shorter than this are written through
+
+void vga_diff_init(vga_diff_t *d, vga_span_t *spans, int max_spans,
+                   unsigned char *pix_a, unsigned char *pix_b, unsigned int max_pix);
+void vga_diff_row(vga_diff_t *d, int y, const unsigned char *a, const unsigned char *b);
+void vga_diff_apply(const vga_diff_t *d, int to_b, volatile unsigned char *vram);
+
+void vga_swap_buffers(void);   // same as vga_present()
 void vga_show_background(void);
 void draw_background(volatile unsigned char *vram);
 